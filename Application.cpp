@@ -18,18 +18,34 @@
 #include <QApplication>
 #include <QDebug>
 #include <QtGui>
+#include "cashflow.hpp"
 #include "Application.hpp"
+#include "Exporter.hpp"
 #include "MainForm.hpp"
 
 using Cashflow::Application;
-
-Application::Application(int &argc, char **argv)
-    : QApplication(argc, argv)
-      , savedLogUndoRedoIndex(0) {
+using Cashflow::Exporter;
+
+// cashflow --export register|periods <cashflow file> <csv or json file>
+static const QString exportSwitch = "--export";
+
+Application::Application(int &argc, char **argv, bool isGuiEnabled)
+    : QApplication(argc, argv, isGuiEnabled)
+      , logUndoRedoIndex(0)
+      , savedLogUndoRedoIndex(0)
+      , endLogUndoRedoIndex(0)
+      , undoCoalesceMilliseconds(UNDO_COALESCE_MILLISECONDS)
+      , undoHorizonDays(UNDO_HORIZON_DAYS)
+      , undoMaxEntries(UNDO_MAX_ENTRIES)
+      , undoCachedRecords(UNDO_CACHED_RECORDS) {
   QCoreApplication::setApplicationName("cashflow");
 
   readSettings();
-  resetForm();
+
+  // an export from the command line runs without ever showing the window
+  if (!isCommandLineExport()) {
+    resetForm();
+  }
 
   // initialize undo log index
   setLogUndoRedoIndexToMax();
@@ -70,34 +86,143 @@ bool Application::open(QString fileName) {
   return isRunningOkay;
 }
 
-bool Application::save() {
-  bool isRunningOkay = data.save();
+bool Application::openReadOnly(QString fileName) {
+  bool isRunningOkay = true;
+
+  isRunningOkay = data.openReadOnly(fileName);
 
+  // the undo log is there to read, but nothing can be undone
 	if (isRunningOkay) {
+    setLogUndoRedoIndexToMax();
 		savedLogUndoRedoIndex = logUndoRedoIndex;
 	}
 
   return isRunningOkay;
 }
 
-bool Application::saveAs() {
-  bool isRunningOkay = data.saveAs();
+bool Application::isReadOnly() const {
+  return data.isReadOnly();
+}
+
+bool Application::isCommandLineExport() const {
+  return arguments().contains(exportSwitch);
+}
+
+bool Application::isCommandLineExport(int argc, char **argv) {
+  bool isExport = false;
+
+  for (int arg = 1; arg < argc && !isExport; ++arg) {
+    isExport = (exportSwitch == argv[arg]);
+  }
+
+  return isExport;
+}
+
+int Application::exportFromCommandLine() {
+  bool isRunningOkay = true;
+
+  QStringList args = arguments();
+  int switchIndex = args.indexOf(exportSwitch);
+
+  Exporter::Source source = Exporter::RegisterSource;
+
+  if (args.count() < switchIndex + 4
+      || !Exporter::sourceFromName(args.at(switchIndex + 1), source)) {
+    qWarning(
+      "usage: cashflow %s register|periods <cashflow file> <csv or json file>"
+      , qPrintable(exportSwitch));
+
+    isRunningOkay = false;
+  }
+
+  // the export only reads, so the file is read in place when it can be,
+  // and compressed and older files are read through a working copy
+  if (isRunningOkay) {
+    isRunningOkay = data.openReadOnly(args.at(switchIndex + 2));
+  }
+
+  if (isRunningOkay) {
+    Exporter exporter;
 
+    isRunningOkay = exporter.write(source, args.at(switchIndex + 3));
+
+    if (isRunningOkay) {
+      qWarning("Exported %d rows", exporter.rowCount());
+    } else {
+      qWarning("Could not export: %s", qPrintable(exporter.errorText()));
+    }
+  }
+
+  return (isRunningOkay ? 0 : 1);
+}
+
+QStringList Application::leftoverWorkingFiles() const {
+  return data.leftoverWorkingFiles();
+}
+
+bool Application::recoverWorkingFile(QString fileName) {
+  bool isRunningOkay = true;
+
+  isRunningOkay = data.recoverWorkingFile(fileName);
+
+  // the recovered undo log carries on, but none of it has been saved
 	if (isRunningOkay) {
-		savedLogUndoRedoIndex = logUndoRedoIndex;
+    setLogUndoRedoIndexToMax();
+		savedLogUndoRedoIndex = 0;
 	}
 
   return isRunningOkay;
 }
 
+void Application::discardWorkingFile(QString fileName) {
+  data.discardWorkingFile(fileName);
+}
+
+// entries are only dropped from before both the current and the saved point
+// at a save, so both stay in the log
+bool Application::save() {
+  compactLogUndoRedo(
+    qMin(logUndoRedoIndex, savedLogUndoRedoIndex), undoHorizonDays);
+
+  return data.save(logUndoRedoIndex);
+}
+
+bool Application::saveAs() {
+  compactLogUndoRedo(
+    qMin(logUndoRedoIndex, savedLogUndoRedoIndex), undoHorizonDays);
+
+  return data.saveAs(logUndoRedoIndex);
+}
+
 bool Application::backupAs() {
-  bool isRunningOkay = data.backupAs();
+  compactLogUndoRedo(
+    qMin(logUndoRedoIndex, savedLogUndoRedoIndex), undoHorizonDays);
+
+  return data.backupAs(logUndoRedoIndex);
+}
 
-  savedLogUndoRedoIndex = logUndoRedoIndex;
+bool Application::autosave() {
+  return data.autosave(logUndoRedoIndex);
+}
+
+bool Application::finishSave() {
+  bool isRunningOkay = data.finishSave();
+
+  // the file holds the log as it stood when the save began, not as it is now;
+  // a working copy holds the log of the file just opened
+	if (isRunningOkay
+      && data.getSaveWorker()->purpose() != SaveWorker::AutosaveFile
+      && data.getSaveWorker()->purpose() != SaveWorker::WorkingCopy) {
+		savedLogUndoRedoIndex = data.getSaveWorker()->logUndoRedoIndex();
+	}
 
   return isRunningOkay;
 }
 
+bool Application::isSaving() const {
+  return data.isSaving();
+}
+
 bool Application::undo() {
   bool isRunningOkay = true;
 
@@ -105,12 +230,17 @@ bool Application::undo() {
     isRunningOkay = false;
   }
 
+  // a group of entries undoes as one step
+  qint64 firstIndex = logUndoRedoIndex;
+
   if (isRunningOkay) {
-    isRunningOkay = data.undo(logUndoRedoIndex);
+    firstIndex = data.undoGroupStart(logUndoRedoIndex);
+
+    isRunningOkay = data.undo(firstIndex, logUndoRedoIndex);
   }
 
   if (isRunningOkay) {
-    --logUndoRedoIndex;
+    logUndoRedoIndex = firstIndex - 1;
   }
 
   return isRunningOkay;
@@ -123,18 +253,29 @@ bool Application::redo() {
     isRunningOkay = false;
   }
 
+  qint64 lastIndex = logUndoRedoIndex;
+
   if (isRunningOkay) {
-    ++logUndoRedoIndex;
-    isRunningOkay = data.redo(logUndoRedoIndex);
+    lastIndex = data.redoGroupEnd(logUndoRedoIndex + 1);
+
+    isRunningOkay = data.redo(logUndoRedoIndex + 1, lastIndex);
   }
 
-  if (!isRunningOkay) {
-    --logUndoRedoIndex;
+  if (isRunningOkay) {
+    logUndoRedoIndex = lastIndex;
   }
 
   return isRunningOkay;
 }
 
+bool Application::beginUndoGroup() {
+  return data.beginUndoGroup();
+}
+
+bool Application::endUndoGroup() {
+  return data.endUndoGroup();
+}
+
 bool Application::categoryHasItems(QString categoryId) {
   return data.categoryHasItems(categoryId);
 }
@@ -202,6 +343,9 @@ void Application::resetForm() {
   form.reset(new MainForm());
 	form->setWindowIcon(QIcon(":/images/icon.png"));
 	form->show();
+
+  // look for work left by a crash once the window is up
+  QTimer::singleShot(0, form.data(), SLOT(offerRecovery()));
 }
 
 void Application::writeSettings() const {
@@ -210,6 +354,19 @@ void Application::writeSettings() const {
   settings.beginGroup("RecentFiles");
   settings.setValue("recentFiles", recentFiles);
   settings.endGroup();
+
+  settings.beginGroup("Performance");
+  settings.setValue("pageSize", data.getPageSize());
+  settings.setValue("cacheSizeKiB", data.getCacheSizeKiB());
+  settings.setValue("mmapSize", data.getMmapSize());
+  settings.endGroup();
+
+  settings.beginGroup("UndoHistory");
+  settings.setValue("coalesceMilliseconds", undoCoalesceMilliseconds);
+  settings.setValue("horizonDays", undoHorizonDays);
+  settings.setValue("maxEntries", undoMaxEntries);
+  settings.setValue("cachedRecords", undoCachedRecords);
+  settings.endGroup();
 }
 
 void Application::readSettings() {
@@ -218,6 +375,24 @@ void Application::readSettings() {
   settings.beginGroup("RecentFiles");
   recentFiles = settings.value("recentFiles").toStringList();
   settings.endGroup();
+
+  settings.beginGroup("Performance");
+  data.setPerformanceProfile(
+    settings.value("pageSize", SQLITE_PAGE_SIZE).toInt()
+    , settings.value("cacheSizeKiB", SQLITE_CACHE_SIZE_KIB).toInt()
+    , settings.value("mmapSize", SQLITE_MMAP_SIZE).toLongLong());
+  settings.endGroup();
+
+  settings.beginGroup("UndoHistory");
+  undoCoalesceMilliseconds =
+    settings.value("coalesceMilliseconds", UNDO_COALESCE_MILLISECONDS).toInt();
+  undoHorizonDays = settings.value("horizonDays", UNDO_HORIZON_DAYS).toInt();
+  undoMaxEntries = settings.value("maxEntries", UNDO_MAX_ENTRIES).toInt();
+  undoCachedRecords =
+    settings.value("cachedRecords", UNDO_CACHED_RECORDS).toInt();
+  settings.endGroup();
+
+  data.setUndoCachedRecordCount(undoCachedRecords);
 }
 
 void Application::clearSavedDatabaseName() {
@@ -238,10 +413,12 @@ bool Application::logUndoRedoIndexAtSaved() {
 
 void Application::setLogUndoRedoIndexToZero() {
   logUndoRedoIndex = 0;
+  endLogUndoRedoIndex = 0;
 }
 
 void Application::setLogUndoRedoIndexToMax() {
   logUndoRedoIndex = data.logUndoRedoCount();
+  endLogUndoRedoIndex = logUndoRedoIndex;
 }
 
 void Application::incrementLogUndoRedoIndex() {
@@ -251,10 +428,30 @@ void Application::incrementLogUndoRedoIndex() {
 bool Application::logUndoRedoChange() {
   bool isRunningOkay = true;
 
-	// remove all redos current one
-  isRunningOkay =
-    data.deleteFromLogUndoRedo(
-  		logUndoRedoIndex + 1, data.logUndoRedoCount() - 1);
+	// remove all redos past the current one, which end where the log did
+	// before the change; a change may have logged several entries since
+  if (logUndoRedoIndex < endLogUndoRedoIndex) {
+    isRunningOkay =
+      data.deleteFromLogUndoRedo(logUndoRedoIndex + 1, endLogUndoRedoIndex);
+  }
+
+  // a quick run of edits to one row, like typing a budget and then fixing
+  // it, undoes as one; the saved entry, and the one a running save is about
+  // to mark saved, are left alone so the file still matches a point in the
+  // log
+  if (isRunningOkay
+      && undoCoalesceMilliseconds > 0
+      && !data.isSaving()
+      && logUndoRedoIndex > savedLogUndoRedoIndex
+      && data.logUndoRedoCount() == logUndoRedoIndex + 1) {
+    data.coalesceLogUndoRedo(logUndoRedoIndex, undoCoalesceMilliseconds);
+  }
+
+  // the oldest entries go once the log is over its budget, even from before
+  // the saved point, which then can no longer be undone back to
+  if (isRunningOkay) {
+    compactLogUndoRedo(logUndoRedoIndex, 0);
+  }
 
   return isRunningOkay;
 }
@@ -269,6 +466,18 @@ bool Application::logUndoRedoClear() {
   return isRunningOkay;
 }
 
+void Application::compactLogUndoRedo(qint64 lastIndex, int horizonDays) {
+  // a save still running has its index already, so the log waits for it
+  if (!data.isSaving()) {
+    qint64 removedCount =
+      data.compactLogUndoRedo(lastIndex, horizonDays, undoMaxEntries);
+
+    logUndoRedoIndex -= removedCount;
+    savedLogUndoRedoIndex -= removedCount;
+    endLogUndoRedoIndex -= removedCount;
+  }
+}
+
 bool Application::getDataModified() const {
   return data.getDataModified();
 }
@@ -277,6 +486,71 @@ void Application::setDataModified(bool isDataModified) {
   data.setDataModified(isDataModified);
 }
 
-void Application::clonePeriodAs(QString sourcePeriodId, QString periodId) {
-  data.clonePeriodAs(sourcePeriodId, periodId);
+void Application::setUnloggedChange() {
+  // a change the undo log does not hold leaves no point in the log that
+  // matches the file, until the next save
+  savedLogUndoRedoIndex = -1;
+
+  data.setDataModified(true);
+}
+
+bool Application::clonePeriodAs(QString sourcePeriodId, QString periodId) {
+  return data.clonePeriodAs(sourcePeriodId, periodId);
+}
+
+bool Application::generatePeriods(
+  QString sourcePeriodId
+  , QStringList periodNames
+  , bool copyBudgets
+  , bool zeroActuals
+  , bool clearNotes)
+{
+  return data.generatePeriods(
+    sourcePeriodId
+    , periodNames
+    , copyBudgets
+    , zeroActuals
+    , clearNotes);
+}
+
+bool Application::registerAllItems(QString periodId) {
+  return data.registerAllItems(periodId);
+}
+
+QStringList Application::changedRegisterItemNames(
+  QString periodId, int &registerCount) const
+{
+  return data.changedRegisterItemNames(periodId, registerCount);
+}
+
+bool Application::unregisterAllItems(QString periodId, bool includeChanged) {
+  return data.unregisterAllItems(periodId, includeChanged);
+}
+
+QStringList Application::unmatchedPayees(QStringList payees) const {
+  return data.unmatchedPayees(payees);
+}
+
+bool Application::addPayeeRules(QMap<QString, QString> itemIdsByPattern) {
+  return data.addPayeeRules(itemIdsByPattern);
+}
+
+bool Application::importStatement(
+  const QList<StatementReader::Total> &totals
+  , int &importedCount
+  , QStringList &missingPeriodNames)
+{
+  return data.importStatement(totals, importedCount, missingPeriodNames);
+}
+
+Cashflow::MetricsCache *Application::getMetricsCache() {
+  return data.getMetricsCache();
+}
+
+Cashflow::SaveWorker *Application::getSaveWorker() {
+  return data.getSaveWorker();
+}
+
+bool Application::reloadMetricsCache() {
+  return data.reloadMetricsCache();
 }
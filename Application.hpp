@@ -33,16 +33,29 @@
   namespace Cashflow {
     class Application : public QApplication {
     public:
-      Application(int &argc, char **argv);
+      Application(int &argc, char **argv, bool isGuiEnabled = true);
       ~Application();
   
       bool newFile();
       bool open(QString filename = QString());
+      bool openReadOnly(QString fileName = QString());
+      bool isReadOnly() const;
+      bool isCommandLineExport() const;
+      static bool isCommandLineExport(int argc, char **argv);
+      int exportFromCommandLine();
+      QStringList leftoverWorkingFiles() const;
+      bool recoverWorkingFile(QString fileName);
+      void discardWorkingFile(QString fileName);
       bool save();
       bool saveAs();
       bool backupAs();
+      bool autosave();
+      bool finishSave();
+      bool isSaving() const;
       bool undo();
       bool redo();
+      bool beginUndoGroup();
+      bool endUndoGroup();
       bool categoryHasItems(QString categoryId);
       bool itemInRegister(QString itemId);
       bool addCurrentFileToRecentList();
@@ -76,20 +89,48 @@
 
       bool getDataModified() const;
       void setDataModified(bool isDataModified);
+      void setUnloggedChange();
 
-      void clonePeriodAs(QString sourcePeriodId, QString periodId);
+      bool clonePeriodAs(QString sourcePeriodId, QString periodId);
+      bool generatePeriods(
+        QString sourcePeriodId
+        , QStringList periodNames
+        , bool copyBudgets
+        , bool zeroActuals
+        , bool clearNotes);
+      bool registerAllItems(QString periodId);
+      QStringList changedRegisterItemNames(
+        QString periodId, int &registerCount) const;
+      bool unregisterAllItems(QString periodId, bool includeChanged);
+      QStringList unmatchedPayees(QStringList payees) const;
+      bool addPayeeRules(QMap<QString, QString> itemIdsByPattern);
+      bool importStatement(
+        const QList<StatementReader::Total> &totals
+        , int &importedCount
+        , QStringList &missingPeriodNames);
+
+      MetricsCache *getMetricsCache();
+      bool reloadMetricsCache();
+
+      SaveWorker *getSaveWorker();
 
     private:
       virtual bool notify(QObject *receiver, QEvent *event);
       void resetForm();
       void writeSettings() const;
       void readSettings();
+      void compactLogUndoRedo(qint64 lastIndex, int horizonDays);
 
       Cashflow::Data data;
       QScopedPointer<MainForm> form;
       QStringList recentFiles;
-      quint16 logUndoRedoIndex;
-      quint16 savedLogUndoRedoIndex;
+      qint64 logUndoRedoIndex;
+      qint64 savedLogUndoRedoIndex;
+      qint64 endLogUndoRedoIndex;
+      int undoCoalesceMilliseconds;
+      int undoHorizonDays;
+      int undoMaxEntries;
+      int undoCachedRecords;
     };
   }
   
@@ -0,0 +1,153 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  CompressedFile class source
+//    The class that packs a database file into the compressed container,
+//    a header followed by zlib blocks, and unpacks it again a block at a time.
+//
+//  container layout
+//    16 byte header       "cashflow-zlib-1\n"
+//    repeated blocks      quint32 length, then that many bytes of qCompress
+//                         output for up to blockSize bytes of the database
+//    end marker           quint32 0
+
+#include <QtCore>
+
+#include "CompressedFile.hpp"
+
+using Cashflow::CompressedFile;
+
+// same length as the "SQLite format 3" header, so either is told apart by
+// reading the first 16 bytes
+const QByteArray compressedFileHeader("cashflow-zlib-1\n");
+
+// file name suffix that asks Save As and Back Up As for the container
+const QString compressedFileSuffix = ".cashflowz";
+
+// uncompressed bytes per block, which bounds the memory either way uses
+const int blockSize = 1024 * 1024;
+
+// anything larger than this cannot have come from one block
+const quint32 maxBlockLength = 2 * blockSize;
+
+bool CompressedFile::isCompressedFileName(QString fileName) {
+  return fileName.endsWith(compressedFileSuffix, Qt::CaseInsensitive);
+}
+
+QString CompressedFile::withCompressedSuffix(QString fileName) {
+  return (
+    isCompressedFileName(fileName)
+    ? fileName
+    : fileName + compressedFileSuffix);
+}
+
+bool CompressedFile::isCompressed(QString fileName) {
+  QFile file(fileName);
+
+  return
+    file.open(QIODevice::ReadOnly)
+    && file.read(compressedFileHeader.size()) == compressedFileHeader;
+}
+
+bool CompressedFile::compress(QString fromFileName, QString toFileName) {
+  bool isRunningOkay = true;
+
+  QFile fromFile(fromFileName);
+  QFile toFile(toFileName);
+
+  isRunningOkay =
+    fromFile.open(QIODevice::ReadOnly)
+    && toFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+
+  if (isRunningOkay) {
+    isRunningOkay =
+      toFile.write(compressedFileHeader) == compressedFileHeader.size();
+  }
+
+  QDataStream out(&toFile);
+
+  while (isRunningOkay && !fromFile.atEnd()) {
+    QByteArray block = qCompress(fromFile.read(blockSize));
+
+    out << (quint32)block.size();
+    out.writeRawData(block.constData(), block.size());
+
+    isRunningOkay = (out.status() == QDataStream::Ok);
+  }
+
+  if (isRunningOkay) {
+    out << (quint32)0;
+
+    isRunningOkay =
+      out.status() == QDataStream::Ok
+      && fromFile.error() == QFile::NoError;
+  }
+
+  return isRunningOkay;
+}
+
+bool CompressedFile::uncompress(QString fromFileName, QString toFileName) {
+  bool isRunningOkay = true;
+
+  QFile fromFile(fromFileName);
+  QFile toFile(toFileName);
+
+  isRunningOkay =
+    fromFile.open(QIODevice::ReadOnly)
+    && fromFile.read(compressedFileHeader.size()) == compressedFileHeader
+    && toFile.open(QIODevice::WriteOnly | QIODevice::Truncate);
+
+  QDataStream in(&fromFile);
+
+  quint32 length = 0;
+
+  if (isRunningOkay) {
+    in >> length;
+  }
+
+  while (isRunningOkay && length > 0) {
+    isRunningOkay =
+      in.status() == QDataStream::Ok
+      && length <= maxBlockLength;
+
+    QByteArray block;
+
+    if (isRunningOkay) {
+      block.resize(length);
+
+      isRunningOkay =
+        in.readRawData(block.data(), length) == (int)length;
+    }
+
+    // qUncompress gives back nothing for a damaged block
+    if (isRunningOkay) {
+      block = qUncompress(block);
+
+      isRunningOkay =
+        !block.isEmpty()
+        && toFile.write(block) == block.size();
+    }
+
+    if (isRunningOkay) {
+      in >> length;
+    }
+  }
+
+  // a file cut short ends without the end marker
+  if (isRunningOkay) {
+    isRunningOkay = (in.status() == QDataStream::Ok);
+  }
+
+  return isRunningOkay;
+}
@@ -0,0 +1,35 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  CompressedFile class definition
+//    The class that packs a database file into the compressed container,
+//    a header followed by zlib blocks, and unpacks it again a block at a time.
+
+#ifndef _CASHFLOW_COMPRESSEDFILE_HPP_
+  #define _CASHFLOW_COMPRESSEDFILE_HPP_
+
+  #include <QString>
+
+  namespace Cashflow {
+    class CompressedFile {
+    public:
+      static bool isCompressedFileName(QString fileName);
+      static QString withCompressedSuffix(QString fileName);
+      static bool isCompressed(QString fileName);
+
+      static bool compress(QString fromFileName, QString toFileName);
+      static bool uncompress(QString fromFileName, QString toFileName);
+    };
+  }
+#endif // _CASHFLOW_COMPRESSEDFILE_HPP_
@@ -0,0 +1,268 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  ConsolidatedReport class source
+//    The class that totals the category rollups of several saved cashflow
+//    files together, reading each file on a thread of its own.
+//
+//  every file is opened read-only on a connection of its own rather than
+//  attached to the working connection, so the files are read side by side,
+//  there is no limit of ten attached files, and the working file stays free
+//  for edits and saves; each thread hands back its file's categoryMetricsView
+//  rows, which are the same partial sums a union all of the files would give
+
+#include <QtCore>
+#include <QtSql>
+
+#include "CompressedFile.hpp"
+#include "ConsolidatedReport.hpp"
+
+using Cashflow::CompressedFile;
+using Cashflow::ConsolidatedReport;
+
+// each reading thread names its connection with this and its file's number
+static const QString reportConnectionName = "cashflowReport";
+
+// the rollups hold integer cents from this schema version on
+static const int minimumDatabaseVersion = 3;
+
+// the flow whose amounts count toward a period balance, as in the
+// periodMetricsView
+static const QString inFlowName = "In";
+
+// periods named by month sort by date, and any others after them by name
+static QString periodSortKey(QString periodName) {
+  QDate date = QLocale::c().toDate(periodName, "MMMM yyyy");
+
+  return (
+    date.isValid()
+    ? "0" + date.toString("yyyy-MM")
+    : "1" + periodName);
+}
+
+static bool rowLessThan(
+    const ConsolidatedReport::Row &left
+    , const ConsolidatedReport::Row &right) {
+  QString leftKey = periodSortKey(left.periodName);
+  QString rightKey = periodSortKey(right.periodName);
+
+  if (leftKey != rightKey) {
+    return leftKey < rightKey;
+  }
+
+  if (left.flowName != right.flowName) {
+    return left.flowName < right.flowName;
+  }
+
+  return left.categoryName < right.categoryName;
+}
+
+// reads one file's category rollups
+class ReportWorker : public QThread {
+public:
+  ReportWorker(QString fileName, int fileNumber)
+      : fileName(fileName)
+      , connectionName(reportConnectionName + QString::number(fileNumber)) {
+    // intentionally empty function
+  }
+
+  QList<ConsolidatedReport::Row> rows;
+  QString errorText;
+
+protected:
+  void run() {
+    bool isRunningOkay = true;
+
+    QString databaseFileName = fileName;
+
+    // a compressed file is unpacked to a temporary file for the reading
+    QTemporaryFile uncompressedFile;
+
+    if (CompressedFile::isCompressed(fileName)) {
+      isRunningOkay = uncompressedFile.open();
+
+      if (isRunningOkay) {
+        databaseFileName = uncompressedFile.fileName();
+        uncompressedFile.close();
+
+        isRunningOkay =
+          CompressedFile::uncompress(fileName, databaseFileName);
+      }
+
+      if (!isRunningOkay) {
+        errorText = QObject::tr("The file could not be uncompressed.");
+      }
+    }
+
+    if (isRunningOkay) {
+      {
+        QSqlDatabase db =
+          QSqlDatabase::addDatabase("QSQLITE", connectionName);
+
+        db.setConnectOptions("QSQLITE_OPEN_READONLY");
+        db.setDatabaseName(databaseFileName);
+
+        if (!db.open()) {
+          errorText = db.lastError().text();
+
+          isRunningOkay = false;
+        }
+
+        if (isRunningOkay) {
+          QSqlQuery query("pragma user_version", db);
+
+          if (!query.next()
+              || query.value(0).toInt() < minimumDatabaseVersion) {
+            errorText =
+              QObject::tr(
+                "The file is from an older version of cashflow; open and "
+                "save it once to upgrade it.");
+
+            isRunningOkay = false;
+          }
+        }
+
+        if (isRunningOkay) {
+          QSqlQuery query(db);
+          query.setForwardOnly(true);
+
+          if (!query.exec(
+                "select\n"
+                "  periodName\n"
+                "  , flowName\n"
+                "  , categoryName\n"
+                "  , budget\n"
+                "  , actual\n"
+                "from\n"
+                "  categoryMetricsView\n")) {
+            errorText = query.lastError().text();
+
+            isRunningOkay = false;
+          }
+
+          while (isRunningOkay && query.next()) {
+            ConsolidatedReport::Row row;
+            row.periodName = query.value(0).toString();
+            row.flowName = query.value(1).toString();
+            row.categoryName = query.value(2).toString();
+            row.budget = query.value(3).toLongLong();
+            row.actual = query.value(4).toLongLong();
+
+            rows << row;
+          }
+        }
+
+        db.close();
+      }
+
+      QSqlDatabase::removeDatabase(connectionName);
+    }
+  }
+
+private:
+  QString fileName;
+  QString connectionName;
+};
+
+bool ConsolidatedReport::run(QStringList fileNames) {
+  categoryRows.clear();
+  reportErrors.clear();
+
+  // at most one reading thread per core runs at a time
+  int batchSize = qMax(QThread::idealThreadCount(), 1);
+
+  QHash<QString, int> rowIndexes;
+
+  for (int first = 0; first < fileNames.count(); first += batchSize) {
+    QList<ReportWorker *> workers;
+
+    for (int file = first;
+        file < qMin(first + batchSize, fileNames.count());
+        ++file) {
+      ReportWorker *worker = new ReportWorker(fileNames.at(file), file);
+      workers << worker;
+
+      worker->start();
+    }
+
+    // the partial sums are merged on this thread as each worker finishes
+    for (int worker = 0; worker < workers.count(); ++worker) {
+      workers.at(worker)->wait();
+
+      if (!workers.at(worker)->errorText.isEmpty()) {
+        reportErrors
+          << QFileInfo(fileNames.at(first + worker)).fileName()
+            + ": " + workers.at(worker)->errorText;
+      }
+
+      foreach(const Row &row, workers.at(worker)->rows) {
+        QString key =
+          row.periodName + "\n" + row.flowName + "\n" + row.categoryName;
+
+        if (rowIndexes.contains(key)) {
+          Row &mergedRow = categoryRows[rowIndexes.value(key)];
+          mergedRow.budget += row.budget;
+          mergedRow.actual += row.actual;
+        } else {
+          rowIndexes.insert(key, categoryRows.count());
+          categoryRows << row;
+        }
+      }
+    }
+
+    qDeleteAll(workers);
+  }
+
+  qSort(categoryRows.begin(), categoryRows.end(), rowLessThan);
+
+  return reportErrors.isEmpty();
+}
+
+QList<ConsolidatedReport::Row> ConsolidatedReport::rows(Level level) const {
+  if (level == CategoryLevel) {
+    return categoryRows;
+  }
+
+  // the category rows are sorted by period and flow, so the rows of each
+  // period or flow follow one another and sum in a single pass
+  QList<Row> levelRows;
+
+  foreach(Row row, categoryRows) {
+    row.categoryName.clear();
+
+    if (level == PeriodLevel) {
+      if (row.flowName != inFlowName) {
+        row.budget = -row.budget;
+        row.actual = -row.actual;
+      }
+
+      row.flowName.clear();
+    }
+
+    if (!levelRows.isEmpty()
+        && levelRows.last().periodName == row.periodName
+        && levelRows.last().flowName == row.flowName) {
+      levelRows.last().budget += row.budget;
+      levelRows.last().actual += row.actual;
+    } else {
+      levelRows << row;
+    }
+  }
+
+  return levelRows;
+}
+
+QStringList ConsolidatedReport::errors() const {
+  return reportErrors;
+}
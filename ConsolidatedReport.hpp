@@ -0,0 +1,55 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  ConsolidatedReport class definition
+//    The class that totals the category rollups of several saved cashflow
+//    files together, reading each file on a thread of its own.
+
+#ifndef _CASHFLOW_CONSOLIDATEDREPORT_HPP_
+  #define _CASHFLOW_CONSOLIDATEDREPORT_HPP_
+
+  #include <QList>
+  #include <QString>
+  #include <QStringList>
+
+  namespace Cashflow {
+    class ConsolidatedReport {
+    public:
+      // one category of one period, summed over every file that has it;
+      // the files are joined up by name since their ids differ
+      struct Row {
+        QString periodName;
+        QString flowName;
+        QString categoryName;
+        qint64 budget;
+        qint64 actual;
+      };
+
+      enum Level {
+        PeriodLevel
+        , FlowLevel
+        , CategoryLevel
+      };
+
+      bool run(QStringList fileNames);
+
+      QList<Row> rows(Level level) const;
+      QStringList errors() const;
+
+    private:
+      QList<Row> categoryRows;
+      QStringList reportErrors;
+    };
+  }
+#endif // _CASHFLOW_CONSOLIDATEDREPORT_HPP_
@@ -0,0 +1,130 @@
+//  Copyright 2014 Jason Eric Timms
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  ConsolidatedReportForm class source
+//    The class that shows the totals of several cashflow files by period,
+//    flow or category.
+
+#include <QtGui>
+
+#include "ConsolidatedReportForm.hpp"
+#include "DecimalFieldItemDelegate.hpp"
+
+using Cashflow::ConsolidatedReport;
+using Cashflow::ConsolidatedReportForm;
+using Cashflow::DecimalFieldItemDelegate;
+
+enum {
+  Report_PeriodName = 0
+  , Report_FlowName = 1
+  , Report_CategoryName = 2
+  , Report_Budget = 3
+  , Report_Actual = 4
+  , Report_Difference = 5
+};
+
+ConsolidatedReportForm::ConsolidatedReportForm(
+    const ConsolidatedReport &report
+    , QStringList fileNames
+    , QWidget *parent) : QDialog(parent), report(report) {
+
+  levelComboBox = new QComboBox(this);
+  levelComboBox->addItem(tr("Period"), ConsolidatedReport::PeriodLevel);
+  levelComboBox->addItem(tr("Flow"), ConsolidatedReport::FlowLevel);
+  levelComboBox->addItem(tr("Category"), ConsolidatedReport::CategoryLevel);
+
+  reportTableWidget = new QTableWidget(0, Report_Difference + 1, this);
+  reportTableWidget->setHorizontalHeaderLabels(
+    QStringList()
+      << tr("Period")
+      << tr("Flow")
+      << tr("Category")
+      << tr("Budget")
+      << tr("Actual")
+      << tr("Difference"));
+  reportTableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  reportTableWidget->verticalHeader()->hide();
+
+  QStringList listedFiles;
+
+  foreach(QString fileName, fileNames) {
+    listedFiles << QFileInfo(fileName).fileName();
+  }
+
+  QLabel *filesLabel =
+    new QLabel(tr("Totals of %1").arg(listedFiles.join(", ")));
+  filesLabel->setWordWrap(true);
+
+  QFormLayout *levelLayout = new QFormLayout;
+  levelLayout->addRow(tr("&Totals by:"), levelComboBox);
+
+  buttonBox = new QDialogButtonBox(QDialogButtonBox::Close);
+
+  connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+  connect(
+    levelComboBox, SIGNAL(currentIndexChanged(int))
+    , this, SLOT(showLevel(int)));
+
+  QVBoxLayout *mainLayout = new QVBoxLayout;
+  mainLayout->addWidget(filesLabel);
+  mainLayout->addLayout(levelLayout);
+  mainLayout->addWidget(reportTableWidget);
+  mainLayout->addWidget(buttonBox);
+  setLayout(mainLayout);
+
+  setWindowTitle(tr("Consolidated Report"));
+  resize(700, 500);
+
+  showLevel(levelComboBox->currentIndex());
+}
+
+void ConsolidatedReportForm::showLevel(int level) {
+  ConsolidatedReport::Level reportLevel =
+    (ConsolidatedReport::Level)levelComboBox->itemData(level).toInt();
+
+  QList<ConsolidatedReport::Row> rows = report.rows(reportLevel);
+
+  reportTableWidget->setRowCount(rows.count());
+
+  for (int row = 0; row < rows.count(); ++row) {
+    const ConsolidatedReport::Row &reportRow = rows.at(row);
+
+    QStringList texts;
+    texts
+      << reportRow.periodName
+      << reportRow.flowName
+      << reportRow.categoryName
+      << DecimalFieldItemDelegate::centsToText(reportRow.budget)
+      << DecimalFieldItemDelegate::centsToText(reportRow.actual)
+      << DecimalFieldItemDelegate::centsToText(
+        reportRow.budget - reportRow.actual);
+
+    for (int column = 0; column < texts.count(); ++column) {
+      QTableWidgetItem *item = new QTableWidgetItem(texts.at(column));
+
+      if (column >= Report_Budget) {
+        item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+      }
+
+      reportTableWidget->setItem(row, column, item);
+    }
+  }
+
+  reportTableWidget->setColumnHidden(
+    Report_FlowName, reportLevel == ConsolidatedReport::PeriodLevel);
+  reportTableWidget->setColumnHidden(
+    Report_CategoryName, reportLevel != ConsolidatedReport::CategoryLevel);
+
+  reportTableWidget->resizeColumnsToContents();
+}
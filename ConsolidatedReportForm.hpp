@@ -0,0 +1,51 @@
+//  Copyright 2014 Jason Eric Timms
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  ConsolidatedReportForm class definition
+//    The class that shows the totals of several cashflow files by period,
+//    flow or category.
+
+#ifndef _CONSOLIDATEDREPORTFORM_HPP_
+  #define _CONSOLIDATEDREPORTFORM_HPP_
+
+  #include <QDialog>
+
+  #include "ConsolidatedReport.hpp"
+
+  class QComboBox;
+  class QDialogButtonBox;
+  class QTableWidget;
+
+  namespace Cashflow {
+    class ConsolidatedReportForm : public QDialog {
+      Q_OBJECT
+  
+    public:
+      ConsolidatedReportForm(
+        const ConsolidatedReport &report
+        , QStringList fileNames
+        , QWidget *parent = (QWidget *)0);
+
+    private slots:
+      void showLevel(int level);
+    
+    private:
+      const ConsolidatedReport &report;
+
+      QComboBox *levelComboBox;
+      QTableWidget *reportTableWidget;
+      QDialogButtonBox *buttonBox;
+    };
+  }
+#endif //_CONSOLIDATEDREPORTFORM_HPP_
@@ -27,37 +27,279 @@
 #include <QtSql>
 #include <QDebug>
 
+#ifdef CASHFLOW_SQLITE_BACKUP
+  #include <sqlite3.h>
+#endif
+
+#include "CompressedFile.hpp"
 #include "Data.hpp"
+#include "UndoLog.hpp"
 #include "cashflow.hpp"
 
+using Cashflow::CompressedFile;
 using Cashflow::Data;
+using Cashflow::UndoLog;
 
 const QString fileTemplate = "cashflow.db";
 
-Data::Data()
-    : dataModified(false) {
+// connection used to look over working files left behind by a crash
+const QString recoveryConnectionName = "cashflowRecovery";
+
+// empty database with the structure and default mappings already in place
+const QString databaseTemplate = ":/database/template.cashflow";
+
+// schema version stored in the file's user_version pragma
+//   1 - lookup indexes on register, item and category
+//   2 - flow and category rollup tables behind the metrics views
+//   3 - register amounts stored as integer cents
+//   4 - time-ordered integer primary keys in place of uuid strings
+//   5 - payee rules that map imported statement payees to items
+//   6 - typed undo log records in place of logged SQL text
+//   7 - the time each undo log entry was logged
+//   8 - a deleted period takes its rollup rows with it
+const int currentDatabaseVersion = 8;
+
+// low bits of a primary key left for ids made in the same millisecond
+const int primaryKeySequenceBits = 20;
+
+// share of free pages in the working file that makes a save reclaim them
+const double reclaimFreePageRatio = 0.25;
+
+// columns after the id of a register row, and the ones of those an edit
+// changes, as the undo log records them
+const int registerRowColumnCount = 5;
+const int registerEditColumnCount = 3;
+
+// pragma auto_vacuum value for incremental mode
+const int incrementalAutoVacuum = 2;
+
+// copy of the working database written in the background between saves
+const QString autosaveFileSuffix = ".autosave";
+
+#ifndef CASHFLOW_SQLITE_BACKUP
+// sqlite's default wal_autocheckpoint, held off while a save copies the file
+const int walAutoCheckpointPages = 1000;
+#endif
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+// pages copied between event loop passes when opening a file
+const int backupPagesPerStep = 256;
+
+// wait before retrying a backup step when the saved file is locked
+const int backupBusyWaitMSecs = 10;
+#endif
+
+// a command-line export runs without a window to show a message box in, so
+// its errors go to the console instead
+static void showWarning(QString title, QString text) {
+  if (QApplication::type() == QApplication::Tty) {
+    qWarning("%s %s", qPrintable(title), qPrintable(text));
+  } else {
+    QMessageBox::warning((QWidget *)0, title, text);
+  }
+}
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+// the Qt driver hands out its own sqlite3 connection to the working file
+static sqlite3 *workingConnection() {
+  sqlite3 *connection = 0;
+
+  QVariant handle = QSqlDatabase::database().driver()->handle();
+
+  if (handle.isValid()
+      && qstrcmp(handle.typeName(), "sqlite3*") == 0) {
+    connection = *static_cast<sqlite3 **>(handle.data());
+  }
+
+  return connection;
+}
+
+// copies every page of the source's main database over the destination's,
+// a slice at a time with the event loop running in between; a cancelled or
+// failed copy is rolled back and leaves the destination as it was
+static bool copyPages(
+    sqlite3 *destination
+    , sqlite3 *source
+    , QString labelText
+    , QString &errorText) {
   bool isRunningOkay = true;
 
-  isRunningOkay = createNewDatabaseFile();
+  sqlite3_backup *backup =
+    sqlite3_backup_init(destination, "main", source, "main");
+
+  if (backup == 0) {
+    errorText = sqlite3_errmsg(destination);
+
+    isRunningOkay = false;
+  }
 
   if (isRunningOkay) {
-    QSqlQuery query;
-    query.exec(
-      "PRAGMA foreign_keys=ON;");
+    QProgressDialog progress(labelText, QObject::tr("Cancel"), 0, 0);
+
+    progress.setWindowModality(Qt::ApplicationModal);
+
+    int result = SQLITE_OK;
+
+    while (
+      (result == SQLITE_OK
+        || result == SQLITE_BUSY
+        || result == SQLITE_LOCKED)
+      && !progress.wasCanceled())
+    {
+      result = sqlite3_backup_step(backup, backupPagesPerStep);
+
+      if (result == SQLITE_BUSY || result == SQLITE_LOCKED) {
+        sqlite3_sleep(backupBusyWaitMSecs);
+      }
+
+      int pageCount = sqlite3_backup_pagecount(backup);
+
+      progress.setMaximum(pageCount);
+      progress.setValue(pageCount - sqlite3_backup_remaining(backup));
+      qApp->processEvents();
+    }
+
+    if (result != SQLITE_DONE) {
+      // leave the error empty for a cancel, which needs no message
+      if (!progress.wasCanceled()) {
+        errorText = sqlite3_errmsg(destination);
+      }
+
+      isRunningOkay = false;
+    }
+  }
+
+  if (backup != 0) {
+    sqlite3_backup_finish(backup);
+  }
+
+  return isRunningOkay;
+}
+#endif
+
+Data::Data()
+    : dataModified(false)
+    , lastPrimaryKeyId(0)
+    , pageSize(SQLITE_PAGE_SIZE)
+    , cacheSizeKiB(SQLITE_CACHE_SIZE_KIB)
+    , mmapSize(SQLITE_MMAP_SIZE)
+    , savePending(false)
+    , readOnly(false) {
+  createNewDatabaseFile();
+}
+
+Data::~Data() {
+  // the thread cannot outlive the object that owns it
+  saveWorker.wait();
+
+  removeAutosaveFile();
+
+  // close before the working file is removed, so the WAL goes with it and a
+  // clean exit leaves nothing behind to recover
+  undoLog.clear();
+  QSqlDatabase::database().close();
+}
+
+// a working file still open in another running copy of the program cannot
+// leave WAL, since that needs the only connection, so this tells a crashed
+// session's file apart and moves its WAL into the file for the copy
+static bool releaseWorkingFile(QString fileName) {
+  bool isRunningOkay = true;
+
+  {
+    QSqlDatabase db =
+      QSqlDatabase::addDatabase("QSQLITE", recoveryConnectionName);
+
+    // a locked file answers at once rather than after the default wait
+    db.setConnectOptions("QSQLITE_BUSY_TIMEOUT=0");
+    db.setDatabaseName(fileName);
+
+    isRunningOkay = db.open();
+
+    if (isRunningOkay) {
+      QSqlQuery query(db);
+
+      isRunningOkay =
+        query.exec("pragma journal_mode = delete;\n")
+        && query.next()
+        && query.value(0).toString() == "delete";
+    }
+
+    // only files that got as far as the default mappings are worth offering
+    if (isRunningOkay) {
+      QSqlQuery query(db);
+
+      isRunningOkay =
+        query.exec("select count(*) from flow;\n")
+        && query.next()
+        && query.value(0).toInt() > 0;
+    }
+
+    db.close();
   }
+
+  QSqlDatabase::removeDatabase(recoveryConnectionName);
+
+  return isRunningOkay;
 }
 
 bool Data::newDatabase() {
+  bool isRunningOkay = true;
+
   // set the to-be-saved database file name to an empty string for now
   clearSavedDatabaseName();
 
-  createDatabaseStructure();
-  prepopulatePermanentData();
-  prepopulateMappableData();
+  // copy the prebuilt template, which is upgraded like any opened file, and
+  // only build the structure and default mappings when that is not possible
+  isRunningOkay =
+    QFile::exists(databaseTemplate)
+    && openDatabaseCopy(databaseTemplate);
+
+  if (!isRunningOkay) {
+    isRunningOkay =
+      (QSqlDatabase::database().isOpen() || createNewDatabaseFile())
+      && buildDatabase();
+  }
 
   setDataModified(false);
 
-  return clearEditableData();
+  return
+    isRunningOkay
+    && clearEditableData()
+    && reloadMetricsCache()
+    && undoLog.load();
+}
+
+bool Data::buildDatabase() {
+  bool isRunningOkay = true;
+
+  QSqlDatabase db = QSqlDatabase::database();
+
+  // the new file's page size and auto vacuum are already set by
+  // applyConnectionProfile, and one transaction keeps the whole build to a
+  // single write of the file
+  bool isInTransaction = db.transaction();
+
+  isRunningOkay = isInTransaction;
+
+  if (isRunningOkay) {
+    isRunningOkay = createDatabaseStructure();
+  }
+
+  if (isRunningOkay) {
+    prepopulatePermanentData();
+    prepopulateMappableData();
+
+    loadLastPrimaryKeyId();
+  }
+
+  if (isRunningOkay) {
+    db.commit();
+  } else if (isInTransaction) {
+    db.rollback();
+  }
+
+  return isRunningOkay;
 }
 
 QString Data::connectionName() {
@@ -75,6 +317,9 @@ QString Data::savedDatabaseName() {
 }
 
 void Data::clearSavedDatabaseName() {
+  // a save still running would set the name again when it finishes
+  finishSave();
+
   // set the to-be-saved database file name to an empty string for now
   savedFileName = "";
 }
@@ -82,26 +327,19 @@ void Data::clearSavedDatabaseName() {
 bool Data::createNewDatabaseFile() {
   bool isRunningOkay = true;
 
-  // create the new working file object
-  workingDatabaseFile.reset(new QTemporaryFile());
-
-  // name the working file
-  workingDatabaseFile->setFileTemplate(
-    QDir::homePath() + QDir::toNativeSeparators("/") + fileTemplate);
+  // the undo statements were prepared against the file being left
+  undoLog.clear();
 
-  // create the working file
-  workingDatabaseFile->open();
-  workingDatabaseFile->close();
+  createWorkingFile();
 
   // create default database connection
   QSqlDatabase db;
-  if (QSqlDatabase::connectionNames().isEmpty()) {
+  if (!QSqlDatabase::contains()) {
 	  db = QSqlDatabase::addDatabase("QSQLITE");
 
   	if (!db.isValid()) {
-  		QMessageBox::warning(
-  			(QWidget *)0
-  			, QObject::tr("Error Type=")
+  		showWarning(
+  			QObject::tr("Error Type=")
   				+ db.lastError().type()
   				+ " "
   				+ QObject::tr("Could not open new database.")
@@ -109,6 +347,9 @@ bool Data::createNewDatabaseFile() {
 
   		isRunningOkay = false;
   	}
+  } else {
+    // the connection left by a file opened read-only is pointed back here
+    db = QSqlDatabase::database(QSqlDatabase::defaultConnection, false);
   }
 
 	if (isRunningOkay) {
@@ -117,9 +358,8 @@ bool Data::createNewDatabaseFile() {
 
 		// open the database
 		if (!db.open()) {
-			QMessageBox::warning(
-				0
-				, QObject::tr("Error: Could not create new database.")
+			showWarning(
+				QObject::tr("Error: Could not create new database.")
 				, db.lastError().text());
 
 			isRunningOkay = false;
@@ -127,9 +367,8 @@ bool Data::createNewDatabaseFile() {
 	}
 
 	if (isRunningOkay && !db.isValid()) {
-		QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
+		showWarning(
+			QObject::tr("Error Type=")
 				+ db.lastError().type()
 				+ " "
 				+ QObject::tr("Could not open new database.")
@@ -138,260 +377,171 @@ bool Data::createNewDatabaseFile() {
 		isRunningOkay = false;
 	}
 
+  if (isRunningOkay) {
+    applyConnectionProfile(true);
+  }
+
   return isRunningOkay;
 }
 
-void Data::createDatabaseStructure() {
-  QProgressDialog progress(
-    QObject::tr("Cashflow")
-    , QString()
-    , 0
-    , 35);
+void Data::createWorkingFile() {
+  // create the new working file object
+  workingDatabaseFile.reset(new QTemporaryFile());
 
-	bool isRunningOkay = true;
+  // name the working file
+  workingDatabaseFile->setFileTemplate(
+    QDir::homePath() + QDir::toNativeSeparators("/") + fileTemplate);
+
+  // create the working file
+  workingDatabaseFile->open();
+  workingDatabaseFile->close();
+}
+
+void Data::applyConnectionProfile(bool isNewFile) {
+  QSqlQuery query;
+
+  query.exec(
+    "PRAGMA foreign_keys=ON;");
+
+  // the page size and auto vacuum of a file only change outside WAL, and
+  // the vacuum rewrites the file with them
+  if (isNewFile) {
+    query.exec(
+      "PRAGMA journal_mode=DELETE;");
+    query.exec(
+      "PRAGMA page_size=" + QString::number(pageSize) + ";");
+    query.exec(
+      "PRAGMA auto_vacuum=INCREMENTAL;");
+    query.exec(
+      "VACUUM;");
+  }
+
+  // WAL lets the save thread read a snapshot while edits carry on, and
+  // with it a commit only syncs at checkpoints yet survives a crash
+  query.exec(
+    "PRAGMA journal_mode=WAL;");
+  query.exec(
+    "PRAGMA synchronous=NORMAL;");
+
+  // a negative cache size is in KiB rather than pages
+  query.exec(
+    "PRAGMA cache_size=" + QString::number(-cacheSizeKiB) + ";");
+  query.exec(
+    "PRAGMA mmap_size=" + QString::number(mmapSize) + ";");
+  query.exec(
+    "PRAGMA temp_store=MEMORY;");
+}
+
+void Data::setPerformanceProfile(
+    int pageSize
+    , int cacheSizeKiB
+    , qint64 mmapSize) {
+  this->pageSize = pageSize;
+  this->cacheSizeKiB = cacheSizeKiB;
+  this->mmapSize = mmapSize;
+
+  // the page size waits for the next new file, the rest apply right away
+  if (QSqlDatabase::database().isOpen()
+      && !readOnly) {
+    applyConnectionProfile(false);
+  }
+}
+
+int Data::getPageSize() const {
+  return pageSize;
+}
+
+int Data::getCacheSizeKiB() const {
+  return cacheSizeKiB;
+}
 
-  progress.setLabelText(QObject::tr("Create database structure ..."));
-  int progressCounter = 0;
+qint64 Data::getMmapSize() const {
+  return mmapSize;
+}
+
+bool Data::createDatabaseStructure() {
+	bool isRunningOkay = true;
 
   if (isRunningOkay) {
     isRunningOkay &= dropPeriodTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= createPeriodTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= dropFlowTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= createFlowTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= dropCategoryTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= createCategoryTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= dropItemTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= createItemTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= dropRegisterTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= createRegisterTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= dropLogUndoRedoTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
     isRunningOkay &= createLogUndoRedoTable();
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
   }
 
   if (isRunningOkay) {
-    QSqlQuery query;
-    query.exec(
-      "create view periodMetricsView as\n"
-      "  select\n"
-      "    per.id as periodId\n"
-      "    , per.name as periodName\n"
-      "    , round(coalesce(\n"
-      "        sum(\n"
-      "          case\n"
-      "            when flowName = 'In' then\n"
-      "              reg.budget\n"
-      "            else\n"
-      "              -reg.budget\n"
-      "          end)\n"
-      "        , 0), 2) as budgetBalance\n"
-      "    , round(coalesce(\n"
-      "        sum(\n"
-      "          case\n"
-      "            when flowName = 'In' then\n"
-      "              reg.actual\n"
-      "            else\n"
-      "              -reg.actual\n"
-      "          end)\n"
-      "        , 0), 2) as actualBalance\n"
-      "    , round(coalesce(\n"
-      "        sum(\n"
-      "          case\n"
-      "            when flowName = 'In' then\n"
-      "              reg.budget\n"
-      "            else\n"
-      "              -reg.budget\n"
-      "          end)\n"
-      "        - sum(\n"
-      "          case\n"
-      "            when flowName = 'In' then\n"
-      "              reg.actual\n"
-      "            else\n"
-      "              -reg.actual\n"
-      "          end)\n"
-      "        , 0), 2) as differenceBalance\n"
-      "  from\n"
-      "    period per\n"
-      "    left outer join\n"
-      "      (select\n"
-      "        reg.periodId\n"
-      "        , flo.name as flowName\n"
-      "        , reg.budget\n"
-      "        , reg.actual\n"
-      "      from\n"
-      "        register reg\n"
-      "        join item ite\n"
-      "          on ite.id = reg.itemId\n"
-      "        join category cat\n"
-      "          on cat.id = ite.categoryId\n"
-      "        join flow flo\n"
-      "          on flo.id = cat.flowId) reg\n"
-      "      on reg.periodId = per.id\n"
-      "  group by\n"
-      "    per.id\n"
-      "    , per.name;\n");
+    isRunningOkay &= dropPayeeRuleTable();
+  }
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+  if (isRunningOkay) {
+    isRunningOkay &= createPayeeRuleTable();
+  }
 
-    query.exec(
-      "create view flowMetricsView as\n"
-      "  select\n"
-      "    reg.periodId\n"
-      "    , flo.id as flowId\n"
-      "    , per.name as periodName\n"
-      "    , flo.name as flowName\n"
-      "    , round(sum(coalesce(reg.budget, 0)), 2) as budget\n"
-      "    , round(sum(coalesce(reg.actual, 0)), 2) as actual\n"
-      "    , round(sum(coalesce(reg.budget, 0) - coalesce(reg.actual, 0)), 2) as difference\n"
-      "  from\n"
-      "    period per\n"
-      "    cross join flow flo\n"
-      "    join category cat\n"
-      "      on cat.flowId = flo.id\n"
-      "    join item ite\n"
-      "      on ite.categoryId = cat.id\n"
-      "    join register reg\n"
-      "      on reg.periodId = per.id\n"
-      "      and reg.itemId = ite.id\n"
-      "  group by\n"
-      "    reg.periodId\n"
-      "    , flo.id\n"
-      "    , per.name\n"
-      "    , flo.name\n");
+  if (isRunningOkay) {
+    isRunningOkay &= createIndexes();
+  }
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+  if (isRunningOkay) {
+    isRunningOkay &= dropRollupTables();
+  }
 
-    query.exec(
-      "create view categoryMetricsView as\n"
-      "  select\n"
-      "    reg.periodId\n"
-      "    , cat.flowId\n"
-      "    , cat.id as categoryId\n"
-      "    , per.name as periodName\n"
-      "    , flo.name as flowName\n"
-      "    , cat.name as categoryName\n"
-      "    , round(sum(coalesce(reg.budget, 0)), 2) as budget\n"
-      "    , round(sum(coalesce(reg.actual, 0)), 2) as actual\n"
-      "    , round(sum(coalesce(reg.budget, 0) - coalesce(reg.actual, 0)), 2) as difference\n"
-      "  from\n"
-      "    period per\n"
-      "    cross join flow flo\n"
-      "    join category cat\n"
-      "      on cat.flowId = flo.id\n"
-      "    join item ite\n"
-      "      on ite.categoryId = cat.id\n"
-      "    join register reg\n"
-      "      on reg.periodId = per.id\n"
-      "      and reg.itemId = ite.id\n"
-      "  group by\n"
-      "    reg.periodId\n"
-      "    , cat.flowId\n"
-      "    , cat.id\n"
-      "    , per.name\n"
-      "    , flo.name\n"
-      "    , cat.name\n");
+  if (isRunningOkay) {
+    isRunningOkay &= createRollupTables();
+  }
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+  if (isRunningOkay) {
+    isRunningOkay &= createRollupTriggers();
+  }
 
-    query.exec(
-      "create view registerMetricsView as\n"
-      "  select\n"
-      "    reg.id as registerId\n"
-      "    , reg.periodId\n"
-      "    , cat.flowId\n"
-      "    , ite.categoryId\n"
-      "    , ite.id as itemId\n"
-      "    , per.name as periodName\n"
-      "    , flo.name as flowName\n"
-      "    , cat.name as categoryName\n"
-      "    , ite.name as itemName\n"
-      "    , reg.note as note\n"
-      "    , round(sum(coalesce(reg.budget, 0)), 2) as budget\n"
-      "    , round(sum(coalesce(reg.actual, 0)), 2) as actual\n"
-      "    , round(sum(coalesce(reg.budget, 0) - coalesce(reg.actual, 0)), 2) as difference\n"
-      "  from\n"
-      "    period per\n"
-      "    cross join flow flo\n"
-      "    join category cat\n"
-      "      on cat.flowId = flo.id\n"
-      "    join item ite\n"
-      "      on ite.categoryId = cat.id\n"
-      "    join register reg\n"
-      "      on reg.periodId = per.id\n"
-      "      and reg.itemId = ite.id\n"
-      "  group by\n"
-      "    reg.id\n"
-      "    , reg.periodId\n"
-      "    , cat.flowId\n"
-      "    , ite.categoryId\n"
-      "    , ite.id\n"
-      "    , per.name\n"
-      "    , flo.name\n"
-      "    , cat.name\n"
-      "    , ite.name\n"
-      "    , reg.note\n");
+  if (isRunningOkay) {
+    QSqlQuery query;
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+    isRunningOkay =
+      createPeriodMetricsView()
+      && createFlowMetricsView()
+      && createCategoryMetricsView()
+      && createRegisterMetricsView();
 
     query.exec(
       "create view unusedMetricsView as\n"
@@ -423,9 +573,6 @@ void Data::createDatabaseStructure() {
       "  having\n"
       "    reg.periodId is null\n");
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
     query.exec(
       "create view categoryMapView as\n"
       "  select\n"
@@ -438,9 +585,6 @@ void Data::createDatabaseStructure() {
       "    join category cat\n"
       "      on cat.flowId = flo.id\n");
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
     query.exec(
       "create view itemMapView as\n"
       "  select\n"
@@ -457,9 +601,6 @@ void Data::createDatabaseStructure() {
       "    join item ite\n"
       "      on ite.categoryId = cat.id\n");
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
     query.exec(
       "create view inCategoryMapView as\n"
       "  select\n"
@@ -474,9 +615,6 @@ void Data::createDatabaseStructure() {
       "  where\n"
       "    flo.name = 'In'\n");
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
     query.exec(
       "create view outCategoryMapView as\n"
       "  select\n"
@@ -491,9 +629,6 @@ void Data::createDatabaseStructure() {
       "  where\n"
       "    flo.name = 'Out'\n");
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
     query.exec(
       "create view inItemMapView as\n"
       "  select\n"
@@ -512,9 +647,6 @@ void Data::createDatabaseStructure() {
       "  where\n"
       "    flo.name = 'In'\n");
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
     query.exec(
       "create view outItemMapView as\n"
       "  select\n"
@@ -533,689 +665,40 @@ void Data::createDatabaseStructure() {
       "  where\n"
       "    flo.name = 'Out'\n");
 
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+    if (isRunningOkay) {
+      isRunningOkay = createMapViewTriggers();
+    }
+  }
 
-    query.exec(
-      "create trigger periodMetricsViewTrigger_InsteadOfUpdate\n"
-      "  instead of\n"
-      "  update on periodMetricsView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    update period\n"
-      "    set\n"
-      "      name = new.periodName\n"
-      "    where\n"
-      "      id = old.periodId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'update period\n' ||"
-      "      'set\n' ||"
-      "      '  name = ' || quote(old.periodName) || '\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(old.periodId) || '\n'\n"
-      "      , 'update period\n' ||"
-      "        'set\n' ||"
-      "        '  name = ' || quote(new.periodName) || '\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.periodId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+  if (isRunningOkay) {
+    isRunningOkay = setDatabaseVersion(currentDatabaseVersion);
+  }
 
-    query.exec(
-      "create trigger periodMetricsViewTrigger_InsteadOfInsert\n"
-      "  instead of\n"
-      "  insert on periodMetricsView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    insert into period(\n"
-      "      id\n"
-      "      , name)\n"
-      "    values(\n"
-      "      new.periodId\n"
-      "      , new.periodName);\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'delete\n' ||"
-      "      'from\n' ||"
-      "      '  period\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(new.periodId) || '\n'\n"
-      "      , 'insert into period(\n' ||"
-      "        '  id\n' ||"
-      "        '  , name)\n' ||"
-      "        'values(\n' ||"
-      "        '  ' || quote(new.periodId) || '\n' ||"
-      "        '  , ' || quote(new.periodName) || ')\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+  return isRunningOkay;
+}
 
-    query.exec(
-      "create trigger periodMetricsViewTrigger_InsteadOfDelete\n"
-      "  instead of\n"
-      "  delete on periodMetricsView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    delete\n"
-      "    from\n"
-      "      period\n"
-      "    where\n"
-      "      id = old.periodId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'insert into period(\n' ||"
-      "      '  id\n' ||"
-      "      '  , name)\n' ||"
-      "      'values(\n' ||"
-      "      '  ' || quote(old.periodId) || '\n' ||"
-      "      '  , ' || quote(old.periodName) || ')\n'\n"
-      "      , 'delete\n' ||"
-      "        'from\n' ||"
-      "        '  period\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.periodId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+bool Data::dropPeriodTable() {
+	bool isRunningOkay = true;
 
-    query.exec(
-      "create trigger flowMetricsViewTrigger_InsteadOfUpdate\n"
-      "  instead of\n"
-      "  update on flowMetricsView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    select *\n"
-      "    from\n"
-      "      flowMetricsView;\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+	QSqlQuery query;
+	query.prepare("drop table if exists period");
+	query.exec();
 
-    query.exec(
-      "create trigger categoryMetricsViewTrigger_InsteadOfUpdate\n"
-      "  instead of\n"
-      "  update on categoryMetricsView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    select *\n"
-      "    from\n"
-      "      categoryMetricsView;\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+	if (isRunningOkay
+			&& !query.isActive()) {
+		QString message = "Invalid drop of period table.";
+		showWarning(
+			QObject::tr("Error Type=")
+				+ query.lastError().type()
+				+ " "
+				+ QObject::tr(message.toUtf8())
+			, ATLINE + ":" + query.lastError().text());
 
-    query.exec(
-      "create trigger registerMetricsViewTrigger_InsteadOfUpdate\n"
-      "  instead of\n"
-      "  update on registerMetricsView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    update register\n"
-      "    set\n"
-      "      budget = new.budget\n"
-      "      , actual = new.actual\n"
-      "      , note = new.note\n"
-      "    where\n"
-      "      id = old.registerId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'update register\n' ||"
-      "      'set\n' ||"
-      "      '  budget = ' || quote(old.budget) || '\n' ||"
-      "      '  , actual = ' || quote(old.actual) || '\n' ||"
-      "      '  , note = ' || quote(old.note) || '\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(old.registerId) || '\n'\n"
-      "      , 'update register\n' ||"
-      "        'set\n' ||"
-      "        '  budget = ' || quote(new.budget) || '\n' ||"
-      "        '  , actual = ' || quote(new.actual) || '\n' ||"
-      "        '  , note = ' || quote(new.note) || '\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.registerId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
+		isRunningOkay = false;
+	}
 
-    query.exec(
-      "create trigger registerMetricsViewTrigger_InsteadOfInsert\n"
-      "  instead of\n"
-      "  insert on registerMetricsView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    insert into register(\n"
-      "      id\n"
-      "      , periodId\n"
-      "      , itemId\n"
-      "      , budget\n"
-      "      , actual\n"
-      "      , note)\n"
-      "    values(\n"
-      "      new.registerId\n"
-      "      , new.periodId\n"
-      "      , new.itemId\n"
-      "      , new.budget\n"
-      "      , new.actual\n"
-      "      , new.note);\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'delete\n' ||"
-      "      'from\n' ||"
-      "      '  register\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(new.registerId) || '\n'\n"
-      "      , 'insert into register(\n' ||"
-      "        '  id\n' ||"
-      "        '  , periodId\n' ||"
-      "        '  , itemId\n' ||"
-      "        '  , budget\n' ||"
-      "        '  , actual\n' ||"
-      "        '  , note)\n' ||"
-      "        'values(\n' ||"
-      "        '  ' || quote(new.registerId) || '\n' ||"
-      "        '  , ' || quote(new.periodId) || '\n' ||"
-      "        '  , ' || quote(new.itemId) || '\n' ||"
-      "        '  , ' || quote(new.budget) || '\n' ||"
-      "        '  , ' || quote(new.actual) || '\n' ||"
-      "        '  , '''')\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger registerMetricsViewTrigger_InsteadOfDelete\n"
-      "  instead of\n"
-      "  delete on registerMetricsView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    delete\n"
-      "    from\n"
-      "      register\n"
-      "    where\n"
-      "      id = old.registerId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'insert into register(\n' ||"
-      "      '  id\n' ||"
-      "      '  , periodId\n' ||"
-      "      '  , itemId\n' ||"
-      "      '  , budget\n' ||"
-      "      '  , actual\n' ||"
-      "      '  , note)\n' ||"
-      "      'values(\n' ||"
-      "      '  ' || quote(old.registerId) || '\n' ||"
-      "      '  , ' || quote(old.periodId) || '\n' ||"
-      "      '  , ' || quote(old.itemId) || '\n' ||"
-      "      '  , ' || quote(old.budget) || '\n' ||"
-      "      '  , ' || quote(old.actual) || '\n' ||"
-      "      '  , ' || quote(old.note) || ')\n'\n"
-      "      , 'delete\n' ||"
-      "        'from\n' ||"
-      "        '  register\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.registerId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger categoryMapViewTrigger_InsteadOfUpdate\n"
-      "  instead of\n"
-      "  update on categoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    update category\n"
-      "    set\n"
-      "      name = new.categoryName\n"
-      "      , flowId = new.flowId\n"
-      "    where\n"
-      "      id = old.categoryId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'update category\n' ||"
-      "      'set\n' ||"
-      "      '  name = ' || quote(old.categoryName) || '\n' ||"
-      "      '  , flowId = ' || quote(old.flowId) || '\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(old.categoryId) || '\n'\n"
-      "      , 'update category\n' ||"
-      "        'set\n' ||"
-      "        '  name = ' || quote(new.categoryName) || '\n' ||"
-      "        '  , flowId = ' || quote(new.flowId) || '\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.categoryId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger categoryMapViewTrigger_InsteadOfInsert\n"
-      "  instead of\n"
-      "  insert on categoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    insert into category(\n"
-      "      id\n"
-      "      , name\n"
-      "      , flowId)\n"
-      "    values(\n"
-      "      new.categoryId\n"
-      "      , new.categoryName\n"
-      "      , new.flowId);\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'delete\n' ||"
-      "      'from\n' ||"
-      "      '  category\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(new.categoryId) || '\n'\n"
-      "      , 'insert into category(\n' ||"
-      "        '  id\n' ||"
-      "        '  , name\n' ||"
-      "        '  , flowId)\n' ||"
-      "        'values(\n' ||"
-      "        '  ' || quote(new.categoryId) || '\n' ||"
-      "        '  , ' || quote(new.categoryName) || '\n' ||"
-      "        '  , ' || quote(new.flowId) || ')\n';\n"
-      "  end\n");
-
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger categoryMapViewTrigger_InsteadOfDelete\n"
-      "  instead of\n"
-      "  delete on categoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    delete\n"
-      "    from\n"
-      "      category\n"
-      "    where\n"
-      "      id = old.categoryId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'insert into category(\n' ||"
-      "      '  id\n' ||"
-      "      '  , name\n' ||"
-      "      '  , flowId)\n' ||"
-      "      'values(\n' ||"
-      "      '  ' || quote(old.categoryId) || '\n' ||"
-      "      '  , ' || quote(old.categoryName) || '\n' ||"
-      "      '  , ' || quote(old.flowId) || ')\n'\n"
-      "      , 'delete\n' ||"
-      "        'from\n' ||"
-      "        '  category\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.categoryId) || '\n';\n"
-      "  end\n");
-
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger inCategoryMapViewTrigger_InsteadOfUpdate\n"
-      "  instead of\n"
-      "  update on inCategoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    update category\n"
-      "    set\n"
-      "      name = new.categoryName\n"
-      "      , flowId = new.flowId\n"
-      "    where\n"
-      "      id = old.categoryId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'update category\n' ||"
-      "      'set\n' ||"
-      "      '  name = ' || quote(old.categoryName) || '\n' ||"
-      "      '  , flowId = ' || quote(old.flowId) || '\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(old.categoryId) || '\n'\n"
-      "      , 'update category\n' ||"
-      "        'set\n' ||"
-      "        '  name = ' || quote(new.categoryName) || '\n' ||"
-      "        '  , flowId = ' || quote(new.flowId) || '\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.categoryId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger inCategoryMapViewTrigger_InsteadOfInsert\n"
-      "  instead of\n"
-      "  insert on inCategoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    insert into category(\n"
-      "      id\n"
-      "      , name\n"
-      "      , flowId)\n"
-      "    values(\n"
-      "      new.categoryId\n"
-      "      , new.categoryName\n"
-      "      , new.flowId);\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'delete\n' ||"
-      "      'from\n' ||"
-      "      '  category\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(new.categoryId) || '\n'\n"
-      "      , 'insert into category(\n' ||"
-      "        '  id\n' ||"
-      "        '  , name\n' ||"
-      "        '  , flowId)\n' ||"
-      "        'values(\n' ||"
-      "        '  ' || quote(new.categoryId) || '\n' ||"
-      "        '  , ' || quote(new.categoryName) || '\n' ||"
-      "        '  , ' || quote(new.flowId) || ')\n';\n"
-      "  end\n");
-
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger inCategoryMapViewTrigger_InsteadOfDelete\n"
-      "  instead of\n"
-      "  delete on inCategoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    delete\n"
-      "    from\n"
-      "      category\n"
-      "    where\n"
-      "      id = old.categoryId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'insert into category(\n' ||"
-      "      '  id\n' ||"
-      "      '  , name\n' ||"
-      "      '  , flowId)\n' ||"
-      "      'values(\n' ||"
-      "      '  ' || quote(old.categoryId) || '\n' ||"
-      "      '  , ' || quote(old.categoryName) || '\n' ||"
-      "      '  , ' || quote(old.flowId) || ')\n'\n"
-      "      , 'delete\n' ||"
-      "        'from\n' ||"
-      "        '  category\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.categoryId) || '\n';\n"
-      "  end\n");
-
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger outCategoryMapViewTrigger_InsteadOfUpdate\n"
-      "  instead of\n"
-      "  update on outCategoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    update category\n"
-      "    set\n"
-      "      name = new.categoryName\n"
-      "      , flowId = new.flowId\n"
-      "    where\n"
-      "      id = old.categoryId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'update category\n' ||"
-      "      'set\n' ||"
-      "      '  name = ' || quote(old.categoryName) || '\n' ||"
-      "      '  , flowId = ' || quote(old.flowId) || '\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(old.categoryId) || '\n'\n"
-      "      , 'update category\n' ||"
-      "        'set\n' ||"
-      "        '  name = ' || quote(new.categoryName) || '\n' ||"
-      "        '  , flowId = ' || quote(new.flowId) || '\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.categoryId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger outCategoryMapViewTrigger_InsteadOfInsert\n"
-      "  instead of\n"
-      "  insert on outCategoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    insert into category(\n"
-      "      id\n"
-      "      , name\n"
-      "      , flowId)\n"
-      "    values(\n"
-      "      new.categoryId\n"
-      "      , new.categoryName\n"
-      "      , new.flowId);\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'delete\n' ||"
-      "      'from\n' ||"
-      "      '  category\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(new.categoryId) || '\n'\n"
-      "      , 'insert into category(\n' ||"
-      "        '  id\n' ||"
-      "        '  , name\n' ||"
-      "        '  , flowId)\n' ||"
-      "        'values(\n' ||"
-      "        '  ' || quote(new.categoryId) || '\n' ||"
-      "        '  , ' || quote(new.categoryName) || '\n' ||"
-      "        '  , ' || quote(new.flowId) || ')\n';\n"
-      "  end\n");
-
-  	progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger outCategoryMapViewTrigger_InsteadOfDelete\n"
-      "  instead of\n"
-      "  delete on outCategoryMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    delete\n"
-      "    from\n"
-      "      category\n"
-      "    where\n"
-      "      id = old.categoryId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'insert into category(\n' ||"
-      "      '  id\n' ||"
-      "      '  , name\n' ||"
-      "      '  , flowId)\n' ||"
-      "      'values(\n' ||"
-      "      '  ' || quote(old.categoryId) || '\n' ||"
-      "      '  , ' || quote(old.categoryName) || '\n' ||"
-      "      '  , ' || quote(old.flowId) || ')\n'\n"
-      "      , 'delete\n' ||"
-      "        'from\n' ||"
-      "        '  category\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.categoryId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger itemMapViewTrigger_InsteadOfUpdate\n"
-      "  instead of\n"
-      "  update on itemMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    update item\n"
-      "    set\n"
-      "      name = new.itemName\n"
-      "      , categoryId = new.categoryId\n"
-      "    where\n"
-      "      id = old.itemId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'update item\n' ||"
-      "      'set\n' ||"
-      "      '  name = ' || quote(old.itemName) || '\n' ||"
-      "      '  , categoryId = ' || quote(old.categoryId) || '\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(old.itemId) || '\n'\n"
-      "      , 'update item\n' ||"
-      "        'set\n' ||"
-      "        '  name = ' || quote(new.itemName) || '\n' ||"
-      "        '  , categoryId = ' || quote(new.categoryId) || '\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.itemId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger itemMapViewTrigger_InsteadOfInsert\n"
-      "  instead of\n"
-      "  insert on itemMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    insert into item(\n"
-      "      id\n"
-      "      , name\n"
-      "      , categoryId)\n"
-      "    values(\n"
-      "      new.itemId\n"
-      "      , new.itemName\n"
-      "      , new.categoryId);\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'delete\n' ||"
-      "      'from\n' ||"
-      "      '  item\n' ||"
-      "      'where\n' ||"
-      "      '  id = ' || quote(new.itemId) || '\n'\n"
-      "      , 'insert into item(\n' ||"
-      "        '  id\n' ||"
-      "        '  , name\n' ||"
-      "        '  , categoryId)\n' ||"
-      "        'values(\n' ||"
-      "        '  ' || quote(new.itemId) || '\n' ||"
-      "        '  , ' || quote(new.itemName) || '\n' ||"
-      "        '  , ' || quote(new.categoryId) || ')\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    query.exec(
-      "create trigger itemMapViewTrigger_InsteadOfDelete\n"
-      "  instead of\n"
-      "  delete on itemMapView\n"
-      "  for each row\n"
-      "  begin\n"
-      "    delete\n"
-      "    from\n"
-      "      item\n"
-      "    where\n"
-      "      id = old.itemId;\n"
-      "    insert into logUndoRedo(\n"
-      "      undoCommand\n"
-      "      , redoCommand)\n"
-      "    select\n"
-      "      'insert into item(\n' ||"
-      "      '  id\n' ||"
-      "      '  , name\n' ||"
-      "      '  , categoryId)\n' ||"
-      "      'values(\n' ||"
-      "      '  ' || quote(old.itemId) || '\n' ||"
-      "      '  , ' || quote(old.itemName) || '\n' ||"
-      "      '  , ' || quote(old.categoryId) || ')\n'\n"
-      "      , 'delete\n' ||"
-      "        'from\n' ||"
-      "        '  item\n' ||"
-      "        'where\n' ||"
-      "        '  id = ' || quote(old.itemId) || '\n';\n"
-      "  end\n");
-
-    progress.setValue(++progressCounter);
-    qApp->processEvents();
-
-    progress.setValue(progress.maximum());
-    qApp->processEvents();
-  }
-}
-
-bool Data::dropPeriodTable() {
-	bool isRunningOkay = true;
-
-	QSqlQuery query;
-	query.prepare("drop table if exists period");
-	query.exec();
-
-	if (isRunningOkay
-			&& !query.isActive()) {
-		QString message = "Invalid drop of period table.";
-		QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
-				+ query.lastError().type()
-				+ " "
-				+ QObject::tr(message.toUtf8())
-			, ATLINE + ":" + query.lastError().text());
-
-		isRunningOkay = false;
-	}
-
-  return isRunningOkay;
-}
+  return isRunningOkay;
+}
 
 bool Data::createPeriodTable() {
 	bool isRunningOkay = true;
@@ -1224,14 +707,13 @@ bool Data::createPeriodTable() {
   	QSqlQuery query;
   	query.exec(
       "create table period(\n"
-      "  id uuid primary key not null\n"
+      "  id integer primary key not null\n"
       "  , name varchar(40) not null)\n");
 
     if (!query.isActive()) {
   		QString message = "Invalid create of period table.";
-  		QMessageBox::warning(
-  			(QWidget *)0
-  			, QObject::tr("Error Type=")
+  		showWarning(
+  			QObject::tr("Error Type=")
   				+ query.lastError().type()
   				+ " "
   				+ QObject::tr(message.toUtf8())
@@ -1254,9 +736,8 @@ bool Data::dropFlowTable() {
 	if (isRunningOkay
 			&& !query.isActive()) {
 		QString message = "Invalid drop of flow table.";
-		QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
+		showWarning(
+			QObject::tr("Error Type=")
 				+ query.lastError().type()
 				+ " "
 				+ QObject::tr(message.toUtf8())
@@ -1275,14 +756,13 @@ bool Data::createFlowTable() {
   	QSqlQuery query;
     query.exec(
       "create table flow(\n"
-      "  id uuid primary key\n"
+      "  id integer primary key\n"
       "  , name varchar(40) not null)\n");
 
     if (!query.isActive()) {
   		QString message = "Invalid create of flow table.";
-  		QMessageBox::warning(
-  			(QWidget *)0
-  			, QObject::tr("Error Type=")
+  		showWarning(
+  			QObject::tr("Error Type=")
   				+ query.lastError().type()
   				+ " "
   				+ QObject::tr(message.toUtf8())
@@ -1305,9 +785,8 @@ bool Data::dropCategoryTable() {
 	if (isRunningOkay
 			&& !query.isActive()) {
 		QString message = "Invalid drop of category table.";
-		QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
+		showWarning(
+			QObject::tr("Error Type=")
 				+ query.lastError().type()
 				+ " "
 				+ QObject::tr(message.toUtf8())
@@ -1326,17 +805,16 @@ bool Data::createCategoryTable() {
   	QSqlQuery query;
     query.exec(
       "create table category(\n"
-      "  id uuid primary key\n"
+      "  id integer primary key\n"
       "  , name varchar(40) not null\n"
-      "  , flowId uuid not null\n"
+      "  , flowId integer not null\n"
       "  , foreign key (flowId) references flow(id)\n"
       "    on delete cascade)\n");
 
     if (!query.isActive()) {
   		QString message = "Invalid create of category table.";
-  		QMessageBox::warning(
-  			(QWidget *)0
-  			, QObject::tr("Error Type=")
+  		showWarning(
+  			QObject::tr("Error Type=")
   				+ query.lastError().type()
   				+ " "
   				+ QObject::tr(message.toUtf8())
@@ -1359,9 +837,8 @@ bool Data::dropItemTable() {
 	if (isRunningOkay
 			&& !query.isActive()) {
 		QString message = "Invalid drop of item table.";
-		QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
+		showWarning(
+			QObject::tr("Error Type=")
 				+ query.lastError().type()
 				+ " "
 				+ QObject::tr(message.toUtf8())
@@ -1380,17 +857,16 @@ bool Data::createItemTable() {
   	QSqlQuery query;
     query.exec(
       "create table item(\n"
-      "  id uuid primary key\n"
+      "  id integer primary key\n"
       "  , name varchar(40) not null\n"
-      "  , categoryId uuid not null\n"
+      "  , categoryId integer not null\n"
       "  , foreign key (categoryId) references category(id)\n"
       "    on delete cascade)\n");
 
     if (!query.isActive()) {
   		QString message = "Invalid create of item table.";
-  		QMessageBox::warning(
-  			(QWidget *)0
-  			, QObject::tr("Error Type=")
+  		showWarning(
+  			QObject::tr("Error Type=")
   				+ query.lastError().type()
   				+ " "
   				+ QObject::tr(message.toUtf8())
@@ -1413,9 +889,8 @@ bool Data::dropRegisterTable() {
 	if (isRunningOkay
 			&& !query.isActive()) {
 		QString message = "Invalid drop of register table.";
-		QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
+		showWarning(
+			QObject::tr("Error Type=")
 				+ query.lastError().type()
 				+ " "
 				+ QObject::tr(message.toUtf8())
@@ -1434,11 +909,11 @@ bool Data::createRegisterTable() {
   	QSqlQuery query;
     query.exec(
       "create table register(\n"
-      "  id uuid primary key\n"
-      "  , periodId uuid not null\n"
-      "  , itemId uuid not null\n"
-      "  , budget real not null\n"
-      "  , actual real not null\n"
+      "  id integer primary key\n"
+      "  , periodId integer not null\n"
+      "  , itemId integer not null\n"
+      "  , budget integer not null\n"
+      "  , actual integer not null\n"
       "  , note text not null default ''\n"
       "  , foreign key (periodId) references period(id)\n"
       "    on delete cascade\n"
@@ -1447,9 +922,8 @@ bool Data::createRegisterTable() {
 
     if (!query.isActive()) {
   		QString message = "Invalid create of register table.";
-  		QMessageBox::warning(
-  			(QWidget *)0
-  			, QObject::tr("Error Type=")
+  		showWarning(
+  			QObject::tr("Error Type=")
   				+ query.lastError().type()
   				+ " "
   				+ QObject::tr(message.toUtf8())
@@ -1472,9 +946,8 @@ bool Data::dropLogUndoRedoTable() {
 	if (isRunningOkay
 			&& !query.isActive()) {
 		QString message = "Invalid drop of logUndoRedo table.";
-		QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
+		showWarning(
+			QObject::tr("Error Type=")
 				+ query.lastError().type()
 				+ " "
 				+ QObject::tr(message.toUtf8())
@@ -1494,14 +967,28 @@ bool Data::createLogUndoRedoTable() {
     query.exec(
       "create table logUndoRedo(\n"
       "  id integer primary key\n"
-      "  , undoCommand text not null\n"
-      "  , redoCommand text not null)\n");
+      "  , operation integer not null\n"
+      "  , tableCode integer\n"
+      "  , rowId integer\n"
+      "  , oldValue1\n"
+      "  , oldValue2\n"
+      "  , oldValue3\n"
+      "  , oldValue4\n"
+      "  , oldValue5\n"
+      "  , newValue1\n"
+      "  , newValue2\n"
+      "  , newValue3\n"
+      "  , newValue4\n"
+      "  , newValue5\n"
+      "  , undoCommand text\n"
+      "  , redoCommand text\n"
+      "  , loggedAt integer not null default (\n"
+      "      cast((julianday('now') - 2440587.5) * 86400000 as integer)))\n");
 
     if (!query.isActive()) {
   		QString message = "Invalid create of logUndoRedo table.";
-  		QMessageBox::warning(
-  			(QWidget *)0
-  			, QObject::tr("Error Type=")
+  		showWarning(
+  			QObject::tr("Error Type=")
   				+ query.lastError().type()
   				+ " "
   				+ QObject::tr(message.toUtf8())
@@ -1514,415 +1001,1801 @@ bool Data::createLogUndoRedoTable() {
   return isRunningOkay;
 }
 
-void Data::prepopulateFlowTable(
-     QProgressDialog &progress
-    , int progressCounter) {
+bool Data::dropPayeeRuleTable() {
+	bool isRunningOkay = true;
 
-  // in flow
-  inFlowId = getNewPrimaryKeyId();
+	QSqlQuery query;
+	query.prepare("drop table if exists payeeRule");
+	query.exec();
 
-  QString inInsertText =
-    "insert into flow(\n"
-    "  id\n"
-    "  , name)\n"
-    "values(\n"
-    "  '" + inFlowId + "'\n"
-    "  , 'In')\n";
+	if (isRunningOkay
+			&& !query.isActive()) {
+		QString message = "Invalid drop of payeeRule table.";
+		showWarning(
+			QObject::tr("Error Type=")
+				+ query.lastError().type()
+				+ " "
+				+ QObject::tr(message.toUtf8())
+			, ATLINE + ":" + query.lastError().text());
 
-  QSqlQuery query;
-  query.exec(inInsertText);
+		isRunningOkay = false;
+	}
 
-  progress.setValue(++progressCounter);
-  qApp->processEvents();
+  return isRunningOkay;
+}
 
-  // out flow
-  outFlowId = getNewPrimaryKeyId();
+bool Data::createPayeeRuleTable() {
+	bool isRunningOkay = true;
 
-  QString outInsertText =
-    "insert into flow(\n"
-    "  id\n"
-    "  , name)\n"
-    "values(\n"
-    "  '" + outFlowId + "'\n"
-    "  , 'Out')\n";
+	if (isRunningOkay) {
+  	QSqlQuery query;
+    query.exec(
+      "create table payeeRule(\n"
+      "  id integer primary key\n"
+      "  , pattern text not null unique collate nocase\n"
+      "  , itemId integer not null\n"
+      "  , foreign key (itemId) references item(id)\n"
+      "    on delete cascade)\n");
 
-  query.exec(outInsertText);
+    if (!query.isActive()) {
+  		QString message = "Invalid create of payeeRule table.";
+  		showWarning(
+  			QObject::tr("Error Type=")
+  				+ query.lastError().type()
+  				+ " "
+  				+ QObject::tr(message.toUtf8())
+  			, ATLINE + ":" + query.lastError().text());
+  
+  		isRunningOkay = false;
+  	}
+  }
 
-  progress.setValue(++progressCounter);
-  qApp->processEvents();
+  return isRunningOkay;
 }
 
-void Data::prepopulateCategoryTable(
-     QProgressDialog &progress
-    , int progressCounter) {
+bool Data::createIndexes() {
+  // index the foreign keys used by the view filters and cascading deletes
+  QStringList statements;
+  statements
+    << "create index if not exists registerPeriodIdItemIdIndex\n"
+       "  on register(periodId, itemId)\n"
+    << "create index if not exists registerItemIdIndex\n"
+       "  on register(itemId)\n"
+    << "create index if not exists itemCategoryIdIndex\n"
+       "  on item(categoryId)\n"
+    << "create index if not exists categoryFlowIdIndex\n"
+       "  on category(flowId)\n";
+
+  return executeStatements(statements, "Invalid create of index.");
+}
 
-  // initialize default in flow (income) categories
-  QStringList inFlowCategories;
-  inFlowCategories
-    << "Gift" << "Property Sales" << "Rebate" << "Refund" << "Reimbursement"
-    << "Salary" << "Savings";
+bool Data::dropRollupTables() {
+  QStringList statements;
+  statements
+    << "drop table if exists flowRollup\n"
+    << "drop table if exists categoryRollup\n";
 
-  foreach(QString inFlowCategory, inFlowCategories) {
-    QString insertText =
-      QString(
-        "insert into category(\n"
-        "  id\n"
-        "  , name\n"
-        "  , flowId)\n"
-        "values(\n"
-        "  '%1'\n"
-        "  , '%2'\n"
-        "  , '%3')\n")
-        .arg(QUuid::createUuid().toString())
-        .arg(inFlowCategory)
-        .arg(inFlowId);
+  return executeStatements(statements, "Invalid drop of rollup tables.");
+}
 
-    QSqlQuery query(insertText);
-  }
+bool Data::createRollupTables() {
+  QStringList statements;
+  statements
+    << "create table flowRollup(\n"
+       "  periodId integer not null\n"
+       "  , flowId integer not null\n"
+       "  , registerCount integer not null default 0\n"
+       "  , budget integer not null default 0\n"
+       "  , actual integer not null default 0\n"
+       "  , primary key (periodId, flowId))\n"
+    << "create table categoryRollup(\n"
+       "  periodId integer not null\n"
+       "  , categoryId integer not null\n"
+       "  , registerCount integer not null default 0\n"
+       "  , budget integer not null default 0\n"
+       "  , actual integer not null default 0\n"
+       "  , primary key (periodId, categoryId))\n";
+
+  return executeStatements(statements, "Invalid create of rollup tables.");
+}
 
-  progress.setValue(++progressCounter);
-  qApp->processEvents();
+bool Data::dropRollupTriggers() {
+  QStringList statements;
+  statements
+    << "drop trigger if exists registerTrigger_AfterInsert\n"
+    << "drop trigger if exists registerTrigger_AfterDelete\n"
+    << "drop trigger if exists registerTrigger_AfterUpdate\n"
+    << "drop trigger if exists periodTrigger_AfterDelete\n"
+    << "drop trigger if exists itemTrigger_AfterUpdateOfCategoryId\n"
+    << "drop trigger if exists categoryTrigger_AfterUpdateOfFlowId\n";
+
+  return executeStatements(statements, "Invalid drop of rollup triggers.");
+}
 
-  // initialize default out flow (expense) categories
-  QStringList outFlowCategories;
-  outFlowCategories
-    << "Business" << "Charitable" << "Clothing" << "Debt" << "Food" << "Health"
-    << "Housing" << "Insurance" << "Personal" << "Recreation" << "Savings"
-    << "Taxes" << "Transportation" << "Travel" << "Utilities";
+bool Data::createRollupTriggers() {
+  QStringList statements;
+  statements
+    << "create trigger registerTrigger_AfterInsert\n"
+       "  after\n"
+       "  insert on register\n"
+       "  for each row\n"
+       "  begin\n"
+       "    insert or ignore into categoryRollup(\n"
+       "      periodId\n"
+       "      , categoryId)\n"
+       "    select\n"
+       "      new.periodId\n"
+       "      , ite.categoryId\n"
+       "    from\n"
+       "      item ite\n"
+       "    where\n"
+       "      ite.id = new.itemId;\n"
+       "    update categoryRollup\n"
+       "    set\n"
+       "      registerCount = registerCount + 1\n"
+       "      , budget = budget + new.budget\n"
+       "      , actual = actual + new.actual\n"
+       "    where\n"
+       "      periodId = new.periodId\n"
+       "      and categoryId =\n"
+       "        (select\n"
+       "          categoryId\n"
+       "        from\n"
+       "          item\n"
+       "        where\n"
+       "          id = new.itemId);\n"
+       "    insert or ignore into flowRollup(\n"
+       "      periodId\n"
+       "      , flowId)\n"
+       "    select\n"
+       "      new.periodId\n"
+       "      , cat.flowId\n"
+       "    from\n"
+       "      item ite\n"
+       "      join category cat\n"
+       "        on cat.id = ite.categoryId\n"
+       "    where\n"
+       "      ite.id = new.itemId;\n"
+       "    update flowRollup\n"
+       "    set\n"
+       "      registerCount = registerCount + 1\n"
+       "      , budget = budget + new.budget\n"
+       "      , actual = actual + new.actual\n"
+       "    where\n"
+       "      periodId = new.periodId\n"
+       "      and flowId =\n"
+       "        (select\n"
+       "          cat.flowId\n"
+       "        from\n"
+       "          item ite\n"
+       "          join category cat\n"
+       "            on cat.id = ite.categoryId\n"
+       "        where\n"
+       "          ite.id = new.itemId);\n"
+       "  end\n"
+    << "create trigger registerTrigger_AfterDelete\n"
+       "  after\n"
+       "  delete on register\n"
+       "  for each row\n"
+       "  begin\n"
+       "    update categoryRollup\n"
+       "    set\n"
+       "      registerCount = registerCount - 1\n"
+       "      , budget = budget - old.budget\n"
+       "      , actual = actual - old.actual\n"
+       "    where\n"
+       "      periodId = old.periodId\n"
+       "      and categoryId =\n"
+       "        (select\n"
+       "          categoryId\n"
+       "        from\n"
+       "          item\n"
+       "        where\n"
+       "          id = old.itemId);\n"
+       "    update flowRollup\n"
+       "    set\n"
+       "      registerCount = registerCount - 1\n"
+       "      , budget = budget - old.budget\n"
+       "      , actual = actual - old.actual\n"
+       "    where\n"
+       "      periodId = old.periodId\n"
+       "      and flowId =\n"
+       "        (select\n"
+       "          cat.flowId\n"
+       "        from\n"
+       "          item ite\n"
+       "          join category cat\n"
+       "            on cat.id = ite.categoryId\n"
+       "        where\n"
+       "          ite.id = old.itemId);\n"
+       "  end\n"
+    << "create trigger registerTrigger_AfterUpdate\n"
+       "  after\n"
+       "  update of periodId, itemId, budget, actual on register\n"
+       "  for each row\n"
+       "  begin\n"
+       "    update categoryRollup\n"
+       "    set\n"
+       "      registerCount = registerCount - 1\n"
+       "      , budget = budget - old.budget\n"
+       "      , actual = actual - old.actual\n"
+       "    where\n"
+       "      periodId = old.periodId\n"
+       "      and categoryId =\n"
+       "        (select\n"
+       "          categoryId\n"
+       "        from\n"
+       "          item\n"
+       "        where\n"
+       "          id = old.itemId);\n"
+       "    update flowRollup\n"
+       "    set\n"
+       "      registerCount = registerCount - 1\n"
+       "      , budget = budget - old.budget\n"
+       "      , actual = actual - old.actual\n"
+       "    where\n"
+       "      periodId = old.periodId\n"
+       "      and flowId =\n"
+       "        (select\n"
+       "          cat.flowId\n"
+       "        from\n"
+       "          item ite\n"
+       "          join category cat\n"
+       "            on cat.id = ite.categoryId\n"
+       "        where\n"
+       "          ite.id = old.itemId);\n"
+       "    insert or ignore into categoryRollup(\n"
+       "      periodId\n"
+       "      , categoryId)\n"
+       "    select\n"
+       "      new.periodId\n"
+       "      , ite.categoryId\n"
+       "    from\n"
+       "      item ite\n"
+       "    where\n"
+       "      ite.id = new.itemId;\n"
+       "    update categoryRollup\n"
+       "    set\n"
+       "      registerCount = registerCount + 1\n"
+       "      , budget = budget + new.budget\n"
+       "      , actual = actual + new.actual\n"
+       "    where\n"
+       "      periodId = new.periodId\n"
+       "      and categoryId =\n"
+       "        (select\n"
+       "          categoryId\n"
+       "        from\n"
+       "          item\n"
+       "        where\n"
+       "          id = new.itemId);\n"
+       "    insert or ignore into flowRollup(\n"
+       "      periodId\n"
+       "      , flowId)\n"
+       "    select\n"
+       "      new.periodId\n"
+       "      , cat.flowId\n"
+       "    from\n"
+       "      item ite\n"
+       "      join category cat\n"
+       "        on cat.id = ite.categoryId\n"
+       "    where\n"
+       "      ite.id = new.itemId;\n"
+       "    update flowRollup\n"
+       "    set\n"
+       "      registerCount = registerCount + 1\n"
+       "      , budget = budget + new.budget\n"
+       "      , actual = actual + new.actual\n"
+       "    where\n"
+       "      periodId = new.periodId\n"
+       "      and flowId =\n"
+       "        (select\n"
+       "          cat.flowId\n"
+       "        from\n"
+       "          item ite\n"
+       "          join category cat\n"
+       "            on cat.id = ite.categoryId\n"
+       "        where\n"
+       "          ite.id = new.itemId);\n"
+       "  end\n"
+    // the register rows go by cascade and leave their totals at zero, but
+    // the rows themselves would stay behind for a period that is gone
+    << "create trigger periodTrigger_AfterDelete\n"
+       "  after\n"
+       "  delete on period\n"
+       "  for each row\n"
+       "  begin\n"
+       "    delete\n"
+       "    from\n"
+       "      categoryRollup\n"
+       "    where\n"
+       "      periodId = old.id;\n"
+       "    delete\n"
+       "    from\n"
+       "      flowRollup\n"
+       "    where\n"
+       "      periodId = old.id;\n"
+       "  end\n"
+    << "create trigger itemTrigger_AfterUpdateOfCategoryId\n"
+       "  after\n"
+       "  update of categoryId on item\n"
+       "  for each row\n"
+       "  when old.categoryId <> new.categoryId\n"
+       "  begin\n"
+       "    delete\n"
+       "    from\n"
+       "      categoryRollup\n"
+       "    where\n"
+       "      categoryId in (old.categoryId, new.categoryId);\n"
+       "    insert into categoryRollup(\n"
+       "      periodId\n"
+       "      , categoryId\n"
+       "      , registerCount\n"
+       "      , budget\n"
+       "      , actual)\n"
+       "    select\n"
+       "      reg.periodId\n"
+       "      , ite.categoryId\n"
+       "      , count(*)\n"
+       "      , sum(reg.budget)\n"
+       "      , sum(reg.actual)\n"
+       "    from\n"
+       "      register reg\n"
+       "      join item ite\n"
+       "        on ite.id = reg.itemId\n"
+       "    where\n"
+       "      ite.categoryId in (old.categoryId, new.categoryId)\n"
+       "    group by\n"
+       "      reg.periodId\n"
+       "      , ite.categoryId;\n"
+       "    delete\n"
+       "    from\n"
+       "      flowRollup\n"
+       "    where\n"
+       "      flowId in\n"
+       "        (select\n"
+       "          flowId\n"
+       "        from\n"
+       "          category\n"
+       "        where\n"
+       "          id in (old.categoryId, new.categoryId));\n"
+       "    insert into flowRollup(\n"
+       "      periodId\n"
+       "      , flowId\n"
+       "      , registerCount\n"
+       "      , budget\n"
+       "      , actual)\n"
+       "    select\n"
+       "      reg.periodId\n"
+       "      , cat.flowId\n"
+       "      , count(*)\n"
+       "      , sum(reg.budget)\n"
+       "      , sum(reg.actual)\n"
+       "    from\n"
+       "      register reg\n"
+       "      join item ite\n"
+       "        on ite.id = reg.itemId\n"
+       "      join category cat\n"
+       "        on cat.id = ite.categoryId\n"
+       "    where\n"
+       "      cat.flowId in\n"
+       "        (select\n"
+       "          flowId\n"
+       "        from\n"
+       "          category\n"
+       "        where\n"
+       "          id in (old.categoryId, new.categoryId))\n"
+       "    group by\n"
+       "      reg.periodId\n"
+       "      , cat.flowId;\n"
+       "  end\n"
+    << "create trigger categoryTrigger_AfterUpdateOfFlowId\n"
+       "  after\n"
+       "  update of flowId on category\n"
+       "  for each row\n"
+       "  when old.flowId <> new.flowId\n"
+       "  begin\n"
+       "    delete\n"
+       "    from\n"
+       "      flowRollup\n"
+       "    where\n"
+       "      flowId in (old.flowId, new.flowId);\n"
+       "    insert into flowRollup(\n"
+       "      periodId\n"
+       "      , flowId\n"
+       "      , registerCount\n"
+       "      , budget\n"
+       "      , actual)\n"
+       "    select\n"
+       "      reg.periodId\n"
+       "      , cat.flowId\n"
+       "      , count(*)\n"
+       "      , sum(reg.budget)\n"
+       "      , sum(reg.actual)\n"
+       "    from\n"
+       "      register reg\n"
+       "      join item ite\n"
+       "        on ite.id = reg.itemId\n"
+       "      join category cat\n"
+       "        on cat.id = ite.categoryId\n"
+       "    where\n"
+       "      cat.flowId in (old.flowId, new.flowId)\n"
+       "    group by\n"
+       "      reg.periodId\n"
+       "      , cat.flowId;\n"
+       "  end\n";
+
+  return executeStatements(statements, "Invalid create of rollup triggers.");
+}
 
-  foreach(QString outFlowCategory, outFlowCategories) {
-    QString insertText =
-      QString(
-        "insert into category(\n"
-        "  id\n"
-        "  , name\n"
-        "  , flowId)\n"
-        "values(\n"
-        "  '%1'\n"
-        "  , '%2'\n"
-        "  , '%3')\n")
-        .arg(QUuid::createUuid().toString())
-        .arg(outFlowCategory)
-        .arg(outFlowId);
+bool Data::fillRollupTables() {
+  QStringList statements;
+  statements
+    << "delete\n"
+       "from\n"
+       "  flowRollup\n"
+    << "insert into flowRollup(\n"
+       "  periodId\n"
+       "  , flowId\n"
+       "  , registerCount\n"
+       "  , budget\n"
+       "  , actual)\n"
+       "select\n"
+       "  reg.periodId\n"
+       "  , cat.flowId\n"
+       "  , count(*)\n"
+       "  , sum(reg.budget)\n"
+       "  , sum(reg.actual)\n"
+       "from\n"
+       "  register reg\n"
+       "  join item ite\n"
+       "    on ite.id = reg.itemId\n"
+       "  join category cat\n"
+       "    on cat.id = ite.categoryId\n"
+       "group by\n"
+       "  reg.periodId\n"
+       "  , cat.flowId\n"
+    << "delete\n"
+       "from\n"
+       "  categoryRollup\n"
+    << "insert into categoryRollup(\n"
+       "  periodId\n"
+       "  , categoryId\n"
+       "  , registerCount\n"
+       "  , budget\n"
+       "  , actual)\n"
+       "select\n"
+       "  reg.periodId\n"
+       "  , ite.categoryId\n"
+       "  , count(*)\n"
+       "  , sum(reg.budget)\n"
+       "  , sum(reg.actual)\n"
+       "from\n"
+       "  register reg\n"
+       "  join item ite\n"
+       "    on ite.id = reg.itemId\n"
+       "group by\n"
+       "  reg.periodId\n"
+       "  , ite.categoryId\n";
+
+  return executeStatements(statements, "Invalid fill of rollup tables.");
+}
 
-    QSqlQuery query(insertText);
+bool Data::createMapViewTriggers() {
+  QStringList statements;
+
+  // the category views differ only in the flows they show, so an edit
+  // through any of them logs the same record
+  QStringList categoryViews;
+  categoryViews
+    << "categoryMapView"
+    << "inCategoryMapView"
+    << "outCategoryMapView";
+
+  foreach(QString view, categoryViews) {
+    statements
+      << "drop trigger if exists " + view + "Trigger_InsteadOfUpdate\n"
+      << "create trigger " + view + "Trigger_InsteadOfUpdate\n"
+         "  instead of\n"
+         "  update on " + view + "\n"
+         "  for each row\n"
+         "  begin\n"
+         "    update category\n"
+         "    set\n"
+         "      name = new.categoryName\n"
+         "      , flowId = new.flowId\n"
+         "    where\n"
+         "      id = old.categoryId;\n"
+         + UndoLog::loggedStatement(
+           UndoLog::UpdateOperation
+           , UndoLog::CategoryTable
+           , "old.categoryId"
+           , QStringList()
+             << "old.categoryName"
+             << "old.flowId"
+           , QStringList()
+             << "new.categoryName"
+             << "new.flowId")
+         + "  end\n"
+      << "drop trigger if exists " + view + "Trigger_InsteadOfInsert\n"
+      << "create trigger " + view + "Trigger_InsteadOfInsert\n"
+         "  instead of\n"
+         "  insert on " + view + "\n"
+         "  for each row\n"
+         "  begin\n"
+         "    insert into category(\n"
+         "      id\n"
+         "      , name\n"
+         "      , flowId)\n"
+         "    values(\n"
+         "      new.categoryId\n"
+         "      , new.categoryName\n"
+         "      , new.flowId);\n"
+         + UndoLog::loggedStatement(
+           UndoLog::InsertOperation
+           , UndoLog::CategoryTable
+           , "new.categoryId"
+           , QStringList()
+           , QStringList()
+             << "new.categoryName"
+             << "new.flowId")
+         + "  end\n"
+      << "drop trigger if exists " + view + "Trigger_InsteadOfDelete\n"
+      << "create trigger " + view + "Trigger_InsteadOfDelete\n"
+         "  instead of\n"
+         "  delete on " + view + "\n"
+         "  for each row\n"
+         "  begin\n"
+         "    delete\n"
+         "    from\n"
+         "      category\n"
+         "    where\n"
+         "      id = old.categoryId;\n"
+         + UndoLog::loggedStatement(
+           UndoLog::DeleteOperation
+           , UndoLog::CategoryTable
+           , "old.categoryId"
+           , QStringList()
+             << "old.categoryName"
+             << "old.flowId"
+           , QStringList())
+         + "  end\n";
   }
 
-  progress.setValue(++progressCounter);
-  qApp->processEvents();
+  statements
+    << "drop trigger if exists itemMapViewTrigger_InsteadOfUpdate\n"
+    << "create trigger itemMapViewTrigger_InsteadOfUpdate\n"
+       "  instead of\n"
+       "  update on itemMapView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    update item\n"
+       "    set\n"
+       "      name = new.itemName\n"
+       "      , categoryId = new.categoryId\n"
+       "    where\n"
+       "      id = old.itemId;\n"
+       + UndoLog::loggedStatement(
+         UndoLog::UpdateOperation
+         , UndoLog::ItemTable
+         , "old.itemId"
+         , QStringList()
+           << "old.itemName"
+           << "old.categoryId"
+         , QStringList()
+           << "new.itemName"
+           << "new.categoryId")
+       + "  end\n"
+    << "drop trigger if exists itemMapViewTrigger_InsteadOfInsert\n"
+    << "create trigger itemMapViewTrigger_InsteadOfInsert\n"
+       "  instead of\n"
+       "  insert on itemMapView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    insert into item(\n"
+       "      id\n"
+       "      , name\n"
+       "      , categoryId)\n"
+       "    values(\n"
+       "      new.itemId\n"
+       "      , new.itemName\n"
+       "      , new.categoryId);\n"
+       + UndoLog::loggedStatement(
+         UndoLog::InsertOperation
+         , UndoLog::ItemTable
+         , "new.itemId"
+         , QStringList()
+         , QStringList()
+           << "new.itemName"
+           << "new.categoryId")
+       + "  end\n"
+    << "drop trigger if exists itemMapViewTrigger_InsteadOfDelete\n"
+    << "create trigger itemMapViewTrigger_InsteadOfDelete\n"
+       "  instead of\n"
+       "  delete on itemMapView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    delete\n"
+       "    from\n"
+       "      item\n"
+       "    where\n"
+       "      id = old.itemId;\n"
+       + UndoLog::loggedStatement(
+         UndoLog::DeleteOperation
+         , UndoLog::ItemTable
+         , "old.itemId"
+         , QStringList()
+           << "old.itemName"
+           << "old.categoryId"
+         , QStringList())
+       + "  end\n";
+
+  return executeStatements(statements, "Invalid create of map view triggers.");
 }
 
-void Data::prepopulateItemTable(
-     QProgressDialog &progress
-    , int progressCounter) {
-  QSqlQuery query;
+bool Data::createPeriodMetricsView() {
+  QStringList statements;
+  statements
+    << "drop view if exists periodMetricsView\n"
+    << "create view periodMetricsView as\n"
+       "  select\n"
+       "    per.id as periodId\n"
+       "    , per.name as periodName\n"
+       "    , coalesce(rol.budgetBalance, 0) as budgetBalance\n"
+       "    , coalesce(rol.actualBalance, 0) as actualBalance\n"
+       "    , coalesce(rol.budgetBalance - rol.actualBalance, 0) as differenceBalance\n"
+       "  from\n"
+       "    period per\n"
+       "    left outer join\n"
+       "      (select\n"
+       "        flr.periodId\n"
+       "        , sum(\n"
+       "            case\n"
+       "              when flo.name = 'In' then\n"
+       "                flr.budget\n"
+       "              else\n"
+       "                -flr.budget\n"
+       "            end) as budgetBalance\n"
+       "        , sum(\n"
+       "            case\n"
+       "              when flo.name = 'In' then\n"
+       "                flr.actual\n"
+       "              else\n"
+       "                -flr.actual\n"
+       "            end) as actualBalance\n"
+       "      from\n"
+       "        flowRollup flr\n"
+       "        join flow flo\n"
+       "          on flo.id = flr.flowId\n"
+       "      group by\n"
+       "        flr.periodId) rol\n"
+       "      on rol.periodId = per.id\n"
+    << "create trigger periodMetricsViewTrigger_InsteadOfUpdate\n"
+       "  instead of\n"
+       "  update on periodMetricsView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    update period\n"
+       "    set\n"
+       "      name = new.periodName\n"
+       "    where\n"
+       "      id = old.periodId;\n"
+       + UndoLog::loggedStatement(
+         UndoLog::UpdateOperation
+         , UndoLog::PeriodTable
+         , "old.periodId"
+         , QStringList()
+           << "old.periodName"
+         , QStringList()
+           << "new.periodName")
+       + "  end\n"
+    << "create trigger periodMetricsViewTrigger_InsteadOfInsert\n"
+       "  instead of\n"
+       "  insert on periodMetricsView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    insert into period(\n"
+       "      id\n"
+       "      , name)\n"
+       "    values(\n"
+       "      new.periodId\n"
+       "      , new.periodName);\n"
+       + UndoLog::loggedStatement(
+         UndoLog::InsertOperation
+         , UndoLog::PeriodTable
+         , "new.periodId"
+         , QStringList()
+         , QStringList()
+           << "new.periodName")
+       + "  end\n"
+    << "create trigger periodMetricsViewTrigger_InsteadOfDelete\n"
+       "  instead of\n"
+       "  delete on periodMetricsView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    delete\n"
+       "    from\n"
+       "      period\n"
+       "    where\n"
+       "      id = old.periodId;\n"
+       + UndoLog::loggedStatement(
+         UndoLog::DeleteOperation
+         , UndoLog::PeriodTable
+         , "old.periodId"
+         , QStringList()
+           << "old.periodName"
+         , QStringList())
+       + "  end\n";
+
+  return executeStatements(statements, "Invalid create of periodMetricsView.");
+}
 
-  // initialize default items
-  insertItem("In", "Gift", "Anniversary Gift");
-  insertItem("In", "Gift", "Birthday Gift");
-  insertItem("In", "Gift", "Christmas Gift");
-  insertItem("In", "Gift", "Easter Gift");
-  insertItem("In", "Gift", "Fathers Day Gift");
-  insertItem("In", "Gift", "Mothers Day Gift");
-  insertItem("In", "Gift", "Holiday Gift");
-  insertItem("In", "Gift", "Congratulations Gift");
-  insertItem("In", "Property Sales", "Misc. Property Resale");
-  insertItem("In", "Rebate", "Misc. Rebate");
-  insertItem("In", "Refund", "Misc. Refund");
-  insertItem("In", "Reimbursement", "Misc. Reimbursement");
-  insertItem("In", "Salary", "Misc. Gross Pay");
-  insertItem("In", "Salary", "Misc. Take Home Pay");
-  insertItem("In", "Savings", "Appliance Fund");
-  insertItem("In", "Savings", "Elective Surgery Fund");
-  insertItem("In", "Savings", "Emergency Fund");
-  insertItem("In", "Savings", "Furniture Fund");
-  insertItem("In", "Savings", "Gift Fund");
-  insertItem("In", "Savings", "Home Insurance Fund");
-  insertItem("In", "Savings", "Home Repair Fund");
-  insertItem("In", "Savings", "New Home Fund");
-  insertItem("In", "Savings", "Next Month's Rent Fund");
-  insertItem("In", "Savings", "Retirement Fund");
-  insertItem("In", "Savings", "Spending Surplus Fund");
-  insertItem("In", "Savings", "Vacation Fund");
-  insertItem("In", "Savings", "Vehicle Insurance Fund");
-  insertItem("In", "Savings", "Vehicle Maintenance Fund");
-  insertItem("In", "Savings", "Vehicle Purchase Fund");
-  insertItem("In", "Savings", "Vet Fund");
-  insertItem("Out", "Food", "Dining Out");
-  insertItem("Out", "Food", "Food Bill");
-  insertItem("Out", "Food", "Grocery");
-  insertItem("Out", "Utilities", "Electricity");
-  insertItem("Out", "Utilities", "Gas");
-  insertItem("Out", "Utilities", "Internet");
-  insertItem("Out", "Utilities", "Phone");
-  insertItem("Out", "Utilities", "TV");
-  insertItem("Out", "Utilities", "Water");
-  insertItem("Out", "Clothing", "Clothes");
-  insertItem("Out", "Clothing", "Laundry And Tailoring");
-  insertItem("Out", "Clothing", "Cleaning");
-  insertItem("Out", "Housing", "Furniture");
-  insertItem("Out", "Housing", "Kitchenware");
-  insertItem("Out", "Housing", "Mortgage");
-  insertItem("Out", "Housing", "Real-Estate Taxes");
-  insertItem("Out", "Housing", "Rent");
-  insertItem("Out", "Housing", "Renters Insurance");
-  insertItem("Out", "Housing", "Repairs And Maintenance");
-  insertItem("Out", "Housing", "Safe Deposit Box");
-  insertItem("Out", "Housing", "Storage");
-  insertItem("Out", "Health", "Allergist");
-  insertItem("Out", "Health", "Chiropractor");
-  insertItem("Out", "Health", "Dentist");
-  insertItem("Out", "Health", "Doctor");
-  insertItem("Out", "Health", "Eye Care");
-  insertItem("Out", "Health", "Hospital");
-  insertItem("Out", "Health", "Medicine");
-  insertItem("Out", "Health", "Spa");
-  insertItem("Out", "Transportation", "Auto Parts");
-  insertItem("Out", "Transportation", "Bus Fair");
-  insertItem("Out", "Transportation", "Car Wash");
-  insertItem("Out", "Transportation", "Gas And Oil");
-  insertItem("Out", "Transportation", "License And Registration");
-  insertItem("Out", "Transportation", "Repairs And Tires");
-  insertItem("Out", "Transportation", "Vehicle History");
-  insertItem("Out", "Taxes", "Federal Income Tax");
-  insertItem("Out", "Taxes", "Federal Medicare Tax");
-  insertItem("Out", "Taxes", "Federal Oasdi Social Security");
-  insertItem("Out", "Taxes", "Income Tax Preparation");
-  insertItem("Out", "Taxes", "Property Tax");
-  insertItem("Out", "Taxes", "State Income Tax");
-  insertItem("Out", "Taxes", "Vehicle Tax");
-  insertItem("Out", "Debt", "Misc");
-  insertItem("Out", "Insurance", "Car Insurance");
-  insertItem("Out", "Insurance", "Dental Insurance");
-  insertItem("Out", "Insurance", "Disability Insurance");
-  insertItem("Out", "Insurance", "Homeowners Insurance");
-  insertItem("Out", "Insurance", "Medical Insurance");
-  insertItem("Out", "Insurance", "Renters Insurance");
-  insertItem("Out", "Insurance", "Term Life Insurance");
-  insertItem("Out", "Insurance", "Travel Insurance");
-  insertItem("Out", "Insurance", "Vision Insurance");
-  insertItem("Out", "Savings", "401K");
-  insertItem("Out", "Savings", "Auto Maintenance Fund");
-  insertItem("Out", "Savings", "Car Insurance Payment Fund");
-  insertItem("Out", "Savings", "Education");
-  insertItem("Out", "Savings", "Elective Surgery");
-  insertItem("Out", "Savings", "Emergency Fund");
-  insertItem("Out", "Savings", "Flex Spending Account");
-  insertItem("Out", "Savings", "Furniture Fund");
-  insertItem("Out", "Savings", "Gift Fund");
-  insertItem("Out", "Savings", "New Home Fund Standby");
-  insertItem("Out", "Savings", "New Home Fund");
-  insertItem("Out", "Savings", "Next Month's Rent");
-  insertItem("Out", "Savings", "Retirement Fund Standby");
-  insertItem("Out", "Savings", "Rothira");
-  insertItem("Out", "Savings", "Spending Surplus");
-  insertItem("Out", "Savings", "Used Vehicle Fund");
-  insertItem("Out", "Savings", "Vacation");
-  insertItem("Out", "Savings", "Vet Fund");
-  insertItem("Out", "Charitible", "Donations Or Tithe");
-  insertItem("Out", "Charitible", "Gifts");
-  insertItem("Out", "Personal", "Cash");
-  insertItem("Out", "Personal", "Convention");
-  insertItem("Out", "Personal", "Firearm");
-  insertItem("Out", "Personal", "Education");
-  insertItem("Out", "Personal", "Gifts");
-  insertItem("Out", "Personal", "Hair Care");
-  insertItem("Out", "Personal", "Organization Dues");
-  insertItem("Out", "Personal", "Pet Care");
-  insertItem("Out", "Personal", "Sales");
-  insertItem("Out", "Personal", "Shipping");
-  insertItem("Out", "Personal", "Stationary");
-  insertItem("Out", "Personal", "Subscriptions");
-  insertItem("Out", "Personal", "Toiletries");
-  insertItem("Out", "Personal", "Veterinarian");
-  insertItem("Out", "Business", "Repairs And Maintenance");
-  insertItem("Out", "Business", "Shipping");
-  insertItem("Out", "Recreation", "Blow");
-  insertItem("Out", "Recreation", "Books");
-  insertItem("Out", "Recreation", "Computer");
-  insertItem("Out", "Recreation", "Electronics");
-  insertItem("Out", "Recreation", "Entertainment");
-  insertItem("Out", "Recreation", "Games");
-  insertItem("Out", "Recreation", "Movies");
-  insertItem("Out", "Recreation", "Sports");
-  insertItem("Out", "Travel", "Cleaning");
-  insertItem("Out", "Travel", "Dining");
-  insertItem("Out", "Travel", "Transportation");
-  insertItem("Out", "Travel", "Groceries");
-  insertItem("Out", "Travel", "Entertainment");
-  insertItem("Out", "Travel", "Lodging");
-  insertItem("Out", "Travel", "Tips");
-
-  progress.setValue(++progressCounter);
-  qApp->processEvents();
+bool Data::createFlowMetricsView() {
+  QStringList statements;
+  statements
+    << "drop view if exists flowMetricsView\n"
+    << "create view flowMetricsView as\n"
+       "  select\n"
+       "    flr.periodId\n"
+       "    , flr.flowId\n"
+       "    , per.name as periodName\n"
+       "    , flo.name as flowName\n"
+       "    , flr.budget\n"
+       "    , flr.actual\n"
+       "    , flr.budget - flr.actual as difference\n"
+       "  from\n"
+       "    flowRollup flr\n"
+       "    join period per\n"
+       "      on per.id = flr.periodId\n"
+       "    join flow flo\n"
+       "      on flo.id = flr.flowId\n"
+       "  where\n"
+       "    flr.registerCount > 0\n"
+    << "create trigger flowMetricsViewTrigger_InsteadOfUpdate\n"
+       "  instead of\n"
+       "  update on flowMetricsView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    select *\n"
+       "    from\n"
+       "      flowMetricsView;\n"
+       "  end\n";
+
+  return executeStatements(statements, "Invalid create of flowMetricsView.");
 }
 
-void Data::insertItem(
-    QString flowName, QString categoryName, QString itemName) {
-  QString insertText(QString(
-    "insert into item(\n"
-    "  id\n"
-    "  , name\n"
-    "  , categoryId)\n"
-    "select\n"
-    "  '%1'\n"
-    "  , '%2'\n"
-    "  , cat.id\n"
-    "from\n"
-    "  flow flo\n"
-    "  join category cat\n"
-    "    on cat.flowId = flo.id\n"
-    "where\n"
-    "  flo.name = '%3'\n"
-    "  and cat.name = '%4'\n")
-    .arg(QUuid::createUuid().toString())
-    .arg(itemName)
-    .arg(flowName)
-    .arg(categoryName));
+bool Data::createCategoryMetricsView() {
+  QStringList statements;
+  statements
+    << "drop view if exists categoryMetricsView\n"
+    << "create view categoryMetricsView as\n"
+       "  select\n"
+       "    car.periodId\n"
+       "    , cat.flowId\n"
+       "    , car.categoryId\n"
+       "    , per.name as periodName\n"
+       "    , flo.name as flowName\n"
+       "    , cat.name as categoryName\n"
+       "    , car.budget\n"
+       "    , car.actual\n"
+       "    , car.budget - car.actual as difference\n"
+       "  from\n"
+       "    categoryRollup car\n"
+       "    join period per\n"
+       "      on per.id = car.periodId\n"
+       "    join category cat\n"
+       "      on cat.id = car.categoryId\n"
+       "    join flow flo\n"
+       "      on flo.id = cat.flowId\n"
+       "  where\n"
+       "    car.registerCount > 0\n"
+    << "create trigger categoryMetricsViewTrigger_InsteadOfUpdate\n"
+       "  instead of\n"
+       "  update on categoryMetricsView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    select *\n"
+       "    from\n"
+       "      categoryMetricsView;\n"
+       "  end\n";
+
+  return executeStatements(statements, "Invalid create of categoryMetricsView.");
+}
 
-  QSqlQuery query(insertText);
+bool Data::createRegisterMetricsView() {
+  QStringList statements;
+  statements
+    << "drop view if exists registerMetricsView\n"
+    << "create view registerMetricsView as\n"
+       "  select\n"
+       "    reg.id as registerId\n"
+       "    , reg.periodId\n"
+       "    , cat.flowId\n"
+       "    , ite.categoryId\n"
+       "    , ite.id as itemId\n"
+       "    , per.name as periodName\n"
+       "    , flo.name as flowName\n"
+       "    , cat.name as categoryName\n"
+       "    , ite.name as itemName\n"
+       "    , reg.note as note\n"
+       "    , sum(coalesce(reg.budget, 0)) as budget\n"
+       "    , sum(coalesce(reg.actual, 0)) as actual\n"
+       "    , sum(coalesce(reg.budget, 0) - coalesce(reg.actual, 0)) as difference\n"
+       "  from\n"
+       "    period per\n"
+       "    cross join flow flo\n"
+       "    join category cat\n"
+       "      on cat.flowId = flo.id\n"
+       "    join item ite\n"
+       "      on ite.categoryId = cat.id\n"
+       "    join register reg\n"
+       "      on reg.periodId = per.id\n"
+       "      and reg.itemId = ite.id\n"
+       "  group by\n"
+       "    reg.id\n"
+       "    , reg.periodId\n"
+       "    , cat.flowId\n"
+       "    , ite.categoryId\n"
+       "    , ite.id\n"
+       "    , per.name\n"
+       "    , flo.name\n"
+       "    , cat.name\n"
+       "    , ite.name\n"
+       "    , reg.note\n"
+    << "create trigger registerMetricsViewTrigger_InsteadOfUpdate\n"
+       "  instead of\n"
+       "  update on registerMetricsView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    update register\n"
+       "    set\n"
+       "      budget = new.budget\n"
+       "      , actual = new.actual\n"
+       "      , note = new.note\n"
+       "    where\n"
+       "      id = old.registerId;\n"
+       + UndoLog::loggedStatement(
+         UndoLog::UpdateOperation
+         , UndoLog::RegisterTable
+         , "old.registerId"
+         , QStringList()
+           << "old.budget"
+           << "old.actual"
+           << "old.note"
+         , QStringList()
+           << "new.budget"
+           << "new.actual"
+           << "new.note")
+       + "  end\n"
+    << "create trigger registerMetricsViewTrigger_InsteadOfInsert\n"
+       "  instead of\n"
+       "  insert on registerMetricsView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    insert into register(\n"
+       "      id\n"
+       "      , periodId\n"
+       "      , itemId\n"
+       "      , budget\n"
+       "      , actual\n"
+       "      , note)\n"
+       "    values(\n"
+       "      new.registerId\n"
+       "      , new.periodId\n"
+       "      , new.itemId\n"
+       "      , new.budget\n"
+       "      , new.actual\n"
+       "      , new.note);\n"
+       + UndoLog::loggedStatement(
+         UndoLog::InsertOperation
+         , UndoLog::RegisterTable
+         , "new.registerId"
+         , QStringList()
+         , QStringList()
+           << "new.periodId"
+           << "new.itemId"
+           << "new.budget"
+           << "new.actual"
+           << "new.note")
+       + "  end\n"
+    << "create trigger registerMetricsViewTrigger_InsteadOfDelete\n"
+       "  instead of\n"
+       "  delete on registerMetricsView\n"
+       "  for each row\n"
+       "  begin\n"
+       "    delete\n"
+       "    from\n"
+       "      register\n"
+       "    where\n"
+       "      id = old.registerId;\n"
+       + UndoLog::loggedStatement(
+         UndoLog::DeleteOperation
+         , UndoLog::RegisterTable
+         , "old.registerId"
+         , QStringList()
+           << "old.periodId"
+           << "old.itemId"
+           << "old.budget"
+           << "old.actual"
+           << "old.note"
+         , QStringList())
+       + "  end\n";
+
+  return executeStatements(statements, "Invalid create of registerMetricsView.");
 }
 
-//void Data::deleteItem(
-//    QString flowName, QString categoryName, QString itemName) {
-//  QString insertText(QString(
-//    "delete ite(\n"
-//    "from\n"
-//    "  flow flo\n"
-//    "  join category cat\n"
-//    "    on cat.flowId = flo.id\n"
-//    "  join item ite\n"
-//    "    on ite.categoryId = cat.id\n"
-//    "where\n"
-//    "  flo.name = '%1'\n"
-//    "  and cat.name = '%2'\n"
-//    "  and ite.name = '%3'\n")
-//    .arg(flowName)
-//    .arg(categoryName)
-//    .arg(itemName));
-//
-//  QSqlQuery query(insertText);
-//}
+bool Data::executeStatements(
+    const QStringList &statements, QString message) {
+	bool isRunningOkay = true;
 
-void Data::prepopulatePermanentData() {
-  QProgressDialog progress(QObject::tr("Cashflow"), QString(), 0, 2);
+  foreach(QString statement, statements) {
+    if (isRunningOkay) {
+    	QSqlQuery query;
+      query.exec(statement);
+
+      if (!query.isActive()) {
+    		showWarning(
+    			QObject::tr("Error Type=")
+    				+ query.lastError().type()
+    				+ " "
+    				+ QObject::tr(message.toUtf8())
+    			, ATLINE + ":" + query.lastError().text());
+
+    		isRunningOkay = false;
+    	}
+    }
+  }
 
-  progress.setLabelText(QObject::tr("Pre-populate permanent data ..."));
-  int progressCounter = 0;
+  return isRunningOkay;
+}
 
-  prepopulateFlowTable(progress, progressCounter);
+bool Data::convertAmountsToCents() {
+  bool isRunningOkay = true;
 
-  progress.setValue(progress.maximum());
-  qApp->processEvents();
-}
+  // the column types change, so the register is rebuilt from a copy
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << "drop table if exists temp.registerCents\n"
+      << "create temporary table registerCents as\n"
+         "  select\n"
+         "    id\n"
+         "    , periodId\n"
+         "    , itemId\n"
+         "    , cast(round(budget * 100) as integer) as budget\n"
+         "    , cast(round(actual * 100) as integer) as actual\n"
+         "    , note\n"
+         "  from\n"
+         "    register\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid copy of register amounts.");
+  }
 
-void Data::prepopulateMappableData() {
-  QProgressDialog progress(QObject::tr("Cashflow"), QString(), 0, 5);
+  if (isRunningOkay) {
+    isRunningOkay =
+      dropRollupTriggers()
+      && dropRollupTables()
+      && dropRegisterTable()
+      && createRegisterTable();
+  }
 
-  progress.setLabelText(QObject::tr("Pre-populate mappable data ..."));
-  int progressCounter = 0;
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << "insert into register(\n"
+         "  id\n"
+         "  , periodId\n"
+         "  , itemId\n"
+         "  , budget\n"
+         "  , actual\n"
+         "  , note)\n"
+         "select\n"
+         "  id\n"
+         "  , periodId\n"
+         "  , itemId\n"
+         "  , budget\n"
+         "  , actual\n"
+         "  , note\n"
+         "from\n"
+         "  temp.registerCents\n"
+      << "drop table temp.registerCents\n"
+      // the logged commands carry amounts in the old units
+      << "delete\n"
+         "from\n"
+         "  logUndoRedo\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid restore of register amounts.");
+  }
 
-  prepopulateCategoryTable(progress, progressCounter);
-  prepopulateItemTable(progress, progressCounter);
+  if (isRunningOkay) {
+    isRunningOkay =
+      createIndexes()
+      && createRollupTables()
+      && createRollupTriggers()
+      && fillRollupTables()
+      && createPeriodMetricsView()
+      && createFlowMetricsView()
+      && createCategoryMetricsView()
+      && createRegisterMetricsView();
+  }
 
-  progress.setValue(progress.maximum());
-  qApp->processEvents();
+  return isRunningOkay;
 }
 
-bool Data::clearEditableData() {
+bool Data::convertKeysToIntegers() {
   bool isRunningOkay = true;
 
-  QSqlQuery query;
-  query.exec(
-    "delete\n"
-    "from\n"
-    "  period\n");
-
-  if (isRunningOkay
-      && query.lastError().isValid()) {
-    QString message = "Invalid clear of period records.";
-    QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
-				+ query.lastError().type()
-				+ " "
-				+ QObject::tr(message.toUtf8())
-      , ATLINE + ":" + query.lastError().text());
+  // map every old key to a new one; the seed row makes the assigned ids
+  // continue from a fresh time-ordered id
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << "drop table if exists temp.keyMap\n"
+      << "create temporary table keyMap(\n"
+         "  newId integer primary key\n"
+         "  , oldId text not null unique)\n"
+      << QString(
+         "insert into temp.keyMap(\n"
+         "  newId\n"
+         "  , oldId)\n"
+         "values(\n"
+         "  %1\n"
+         "  , '')\n").arg(getNewPrimaryKeyId())
+      << "insert into temp.keyMap(oldId) select id from flow\n"
+      << "insert into temp.keyMap(oldId) select id from category\n"
+      << "insert into temp.keyMap(oldId) select id from item\n"
+      << "insert into temp.keyMap(oldId) select id from period\n"
+      << "insert into temp.keyMap(oldId) select id from register\n"
+      << "delete\n"
+         "from\n"
+         "  temp.keyMap\n"
+         "where\n"
+         "  oldId = ''\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid create of primary key map.");
+  }
 
-    isRunningOkay = false;
+  // copy the rows under their new keys
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << "create temporary table flowCopy as\n"
+         "  select\n"
+         "    flk.newId as id\n"
+         "    , flo.name\n"
+         "  from\n"
+         "    flow flo\n"
+         "    join temp.keyMap flk\n"
+         "      on flk.oldId = flo.id\n"
+      << "create temporary table categoryCopy as\n"
+         "  select\n"
+         "    cak.newId as id\n"
+         "    , cat.name\n"
+         "    , flk.newId as flowId\n"
+         "  from\n"
+         "    category cat\n"
+         "    join temp.keyMap cak\n"
+         "      on cak.oldId = cat.id\n"
+         "    join temp.keyMap flk\n"
+         "      on flk.oldId = cat.flowId\n"
+      << "create temporary table itemCopy as\n"
+         "  select\n"
+         "    itk.newId as id\n"
+         "    , ite.name\n"
+         "    , cak.newId as categoryId\n"
+         "  from\n"
+         "    item ite\n"
+         "    join temp.keyMap itk\n"
+         "      on itk.oldId = ite.id\n"
+         "    join temp.keyMap cak\n"
+         "      on cak.oldId = ite.categoryId\n"
+      << "create temporary table periodCopy as\n"
+         "  select\n"
+         "    pek.newId as id\n"
+         "    , per.name\n"
+         "  from\n"
+         "    period per\n"
+         "    join temp.keyMap pek\n"
+         "      on pek.oldId = per.id\n"
+      << "create temporary table registerCopy as\n"
+         "  select\n"
+         "    rek.newId as id\n"
+         "    , pek.newId as periodId\n"
+         "    , itk.newId as itemId\n"
+         "    , reg.budget\n"
+         "    , reg.actual\n"
+         "    , reg.note\n"
+         "  from\n"
+         "    register reg\n"
+         "    join temp.keyMap rek\n"
+         "      on rek.oldId = reg.id\n"
+         "    join temp.keyMap pek\n"
+         "      on pek.oldId = reg.periodId\n"
+         "    join temp.keyMap itk\n"
+         "      on itk.oldId = reg.itemId\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid copy of rows to new keys.");
   }
 
+  // drop children before parents so no cascading delete reaches a kept row
   if (isRunningOkay) {
-    query.exec(
-      "delete\n"
-      "from\n"
-      "  register\n");
+    isRunningOkay =
+      dropRollupTriggers()
+      && dropRollupTables()
+      && dropRegisterTable()
+      && dropItemTable()
+      && dropCategoryTable()
+      && dropFlowTable()
+      && dropPeriodTable()
+      && createPeriodTable()
+      && createFlowTable()
+      && createCategoryTable()
+      && createItemTable()
+      && createRegisterTable();
   }
 
-  if (isRunningOkay
-      && query.lastError().isValid()) {
-    QString message = "Invalid clear of register records.";
-    QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
-				+ query.lastError().type()
-				+ " "
-				+ QObject::tr(message.toUtf8())
-      , ATLINE + ":" + query.lastError().text());
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << "insert into period(id, name)\n"
+         "select id, name from temp.periodCopy\n"
+      << "insert into flow(id, name)\n"
+         "select id, name from temp.flowCopy\n"
+      << "insert into category(id, name, flowId)\n"
+         "select id, name, flowId from temp.categoryCopy\n"
+      << "insert into item(id, name, categoryId)\n"
+         "select id, name, categoryId from temp.itemCopy\n"
+      << "insert into register(id, periodId, itemId, budget, actual, note)\n"
+         "select id, periodId, itemId, budget, actual, note\n"
+         "from temp.registerCopy\n"
+      << "drop table temp.registerCopy\n"
+      << "drop table temp.periodCopy\n"
+      << "drop table temp.itemCopy\n"
+      << "drop table temp.categoryCopy\n"
+      << "drop table temp.flowCopy\n"
+      << "drop table temp.keyMap\n"
+      // the logged commands name rows by their old keys
+      << "delete\n"
+         "from\n"
+         "  logUndoRedo\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid restore of rows to new keys.");
+  }
 
-    isRunningOkay = false;
+  if (isRunningOkay) {
+    isRunningOkay =
+      createIndexes()
+      && createRollupTables()
+      && createRollupTriggers()
+      && fillRollupTables();
   }
 
   return isRunningOkay;
 }
 
+bool Data::convertUndoLogToRecords() {
+  bool isRunningOkay = true;
 
-void Data::fillPeriodWithAllItems(QString period) {
-  QSqlQuery query;
+  // set the logged text aside, since the table is made again with the
+  // record columns
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << "drop table if exists temp.logUndoRedoText\n"
+      << "create temporary table logUndoRedoText as\n"
+         "  select\n"
+         "    id\n"
+         "    , undoCommand\n"
+         "    , redoCommand\n"
+         "  from\n"
+         "    logUndoRedo\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid copy of the undo log.");
+  }
 
-  // add all items for each period
-  query.exec(
-    "insert into register(\n"
-    "  periodId\n"
-    "  , itemId\n"
-    "  , budget\n"
-    "  , actual\n"
-    "  , note)\n"
-    "select\n"
-    "  per.id\n"
-    "  , ite.id\n"
-    "  , 0.00\n"
-    "  , 0.00\n"
-    "  , ''\n"
-    "from\n"
-    "  period per\n"
-    "  cross join item ite\n"
-    "where\n"
-    "  per.periodId = '" + period + "';\n");
+  if (isRunningOkay) {
+    isRunningOkay =
+      dropLogUndoRedoTable()
+      && createLogUndoRedoTable();
+  }
 
-  if (!query.isValid()) {
-    QString message = "Invalid query.";
-    QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
-				+ query.lastError().type()
-				+ " "
-				+ QObject::tr(message.toUtf8())
-      , ATLINE + ":" + query.lastError().text());
+  // the history so far carries on as commands, which replay as before
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << QString(
+         "insert into logUndoRedo(\n"
+         "  id\n"
+         "  , operation\n"
+         "  , undoCommand\n"
+         "  , redoCommand)\n"
+         "select\n"
+         "  id\n"
+         "  , %1\n"
+         "  , undoCommand\n"
+         "  , redoCommand\n"
+         "from\n"
+         "  temp.logUndoRedoText\n").arg(UndoLog::CommandOperation)
+      << "drop table temp.logUndoRedoText\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid restore of the undo log.");
   }
+
+  // the views' triggers write the records from here on
+  if (isRunningOkay) {
+    isRunningOkay =
+      createMapViewTriggers()
+      && createPeriodMetricsView()
+      && createRegisterMetricsView();
+  }
+
+  return isRunningOkay;
 }
 
-void Data::fillAllPeriodsWithAllItems() {
-  QSqlQuery query;
+bool Data::addUndoLogTimes() {
+  bool isRunningOkay = true;
 
-  // add all items for each period
-  query.exec(
-    "insert into register(\n"
-    "  periodId\n"
-    "  , itemId\n"
-    "  , budget\n"
-    "  , actual)\n"
-    "select\n"
+  // a column with a default worked out per row cannot be added in place, so
+  // the log is set aside and the table made again
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << "drop table if exists temp.logUndoRedoUntimed\n"
+      << "create temporary table logUndoRedoUntimed as\n"
+         "  select\n"
+         "    *\n"
+         "  from\n"
+         "    logUndoRedo\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid copy of the undo log.");
+  }
+
+  if (isRunningOkay) {
+    isRunningOkay =
+      dropLogUndoRedoTable()
+      && createLogUndoRedoTable();
+  }
+
+  // the entries so far count as logged now, so none of them is compacted
+  // away by the first save
+  if (isRunningOkay) {
+    QStringList statements;
+    statements
+      << "insert into logUndoRedo(\n"
+         "  id\n"
+         "  , operation\n"
+         "  , tableCode\n"
+         "  , rowId\n"
+         "  , oldValue1\n"
+         "  , oldValue2\n"
+         "  , oldValue3\n"
+         "  , oldValue4\n"
+         "  , oldValue5\n"
+         "  , newValue1\n"
+         "  , newValue2\n"
+         "  , newValue3\n"
+         "  , newValue4\n"
+         "  , newValue5\n"
+         "  , undoCommand\n"
+         "  , redoCommand)\n"
+         "select\n"
+         "  id\n"
+         "  , operation\n"
+         "  , tableCode\n"
+         "  , rowId\n"
+         "  , oldValue1\n"
+         "  , oldValue2\n"
+         "  , oldValue3\n"
+         "  , oldValue4\n"
+         "  , oldValue5\n"
+         "  , newValue1\n"
+         "  , newValue2\n"
+         "  , newValue3\n"
+         "  , newValue4\n"
+         "  , newValue5\n"
+         "  , undoCommand\n"
+         "  , redoCommand\n"
+         "from\n"
+         "  temp.logUndoRedoUntimed\n"
+      << "drop table temp.logUndoRedoUntimed\n";
+
+    isRunningOkay =
+      executeStatements(statements, "Invalid restore of the undo log.");
+  }
+
+  return isRunningOkay;
+}
+
+int Data::databaseVersion() const {
+  QSqlQuery query(
+    "pragma user_version;\n");
+
+  int version = 0;
+
+  if (query.next()) {
+    version = query.value(0).toInt();
+  }
+
+  return version;
+}
+
+bool Data::setDatabaseVersion(int version) {
+	bool isRunningOkay = true;
+
+  // pragmas cannot take bound values
+	QSqlQuery query;
+  query.exec(QString("pragma user_version = %1;\n").arg(version));
+
+  if (!query.isActive()) {
+		QString message = "Invalid set of database version.";
+		showWarning(
+			QObject::tr("Error Type=")
+				+ query.lastError().type()
+				+ " "
+				+ QObject::tr(message.toUtf8())
+			, ATLINE + ":" + query.lastError().text());
+
+		isRunningOkay = false;
+	}
+
+  return isRunningOkay;
+}
+
+bool Data::upgradeDatabaseStructure() {
+  bool isRunningOkay = true;
+
+  QSqlDatabase db = QSqlDatabase::database();
+
+  int version = databaseVersion();
+
+  // refuse files written by a newer version of the program
+  if (version > currentDatabaseVersion) {
+		showWarning(
+			QObject::tr("Could not open existing database.")
+			, QObject::tr("The file was created by a newer version of cashflow."));
+
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay
+      && version < currentDatabaseVersion) {
+    db.transaction();
+
+    // version 1 adds the lookup indexes
+    if (isRunningOkay
+        && version < 1) {
+      isRunningOkay = createIndexes();
+    }
+
+    // version 2 replaces the metrics view scans with rollup tables
+    if (isRunningOkay
+        && version < 2) {
+      isRunningOkay =
+        createRollupTables()
+        && createRollupTriggers()
+        && fillRollupTables()
+        && createPeriodMetricsView()
+        && createFlowMetricsView()
+        && createCategoryMetricsView();
+    }
+
+    // version 3 stores the register amounts as integer cents
+    if (isRunningOkay
+        && version < 3) {
+      isRunningOkay = convertAmountsToCents();
+    }
+
+    // version 4 replaces the uuid strings with integer primary keys
+    if (isRunningOkay
+        && version < 4) {
+      isRunningOkay = convertKeysToIntegers();
+    }
+
+    // version 5 adds the payee rules used by the statement import
+    if (isRunningOkay
+        && version < 5) {
+      isRunningOkay = createPayeeRuleTable();
+    }
+
+    // version 6 logs typed undo records in place of SQL text
+    if (isRunningOkay
+        && version < 6) {
+      isRunningOkay = convertUndoLogToRecords();
+    }
+
+    // version 7 stamps each undo log entry with the time it was logged
+    if (isRunningOkay
+        && version < 7) {
+      isRunningOkay = addUndoLogTimes();
+    }
+
+    // version 8 clears a deleted period's rollup rows, and the refill drops
+    // the ones left behind so far
+    if (isRunningOkay
+        && version < 8) {
+      isRunningOkay =
+        dropRollupTriggers()
+        && createRollupTriggers()
+        && fillRollupTables();
+    }
+
+    if (isRunningOkay) {
+      isRunningOkay = setDatabaseVersion(currentDatabaseVersion);
+    }
+
+    if (isRunningOkay) {
+      db.commit();
+    } else {
+      db.rollback();
+    }
+  }
+
+  return isRunningOkay;
+}
+
+void Data::prepopulateFlowTable() {
+  QSqlQuery query;
+  query.prepare(
+    "insert into flow(\n"
+    "  id\n"
+    "  , name)\n"
+    "values(\n"
+    "  ?\n"
+    "  , ?)\n");
+
+  // in flow
+  inFlowId = getNewPrimaryKeyId();
+
+  query.addBindValue(inFlowId.toLongLong());
+  query.addBindValue("In");
+  query.exec();
+
+  // out flow
+  outFlowId = getNewPrimaryKeyId();
+
+  query.addBindValue(outFlowId.toLongLong());
+  query.addBindValue("Out");
+  query.exec();
+}
+
+void Data::prepopulateCategoryTable() {
+  QSqlQuery query;
+  query.prepare(
+    "insert into category(\n"
+    "  id\n"
+    "  , name\n"
+    "  , flowId)\n"
+    "values(\n"
+    "  ?\n"
+    "  , ?\n"
+    "  , ?)\n");
+
+  // initialize default in flow (income) categories
+  QStringList inFlowCategories;
+  inFlowCategories
+    << "Gift" << "Property Sales" << "Rebate" << "Refund" << "Reimbursement"
+    << "Salary" << "Savings";
+
+  foreach(QString inFlowCategory, inFlowCategories) {
+    query.addBindValue(getNewPrimaryKeyId().toLongLong());
+    query.addBindValue(inFlowCategory);
+    query.addBindValue(inFlowId.toLongLong());
+    query.exec();
+  }
+
+  // initialize default out flow (expense) categories
+  QStringList outFlowCategories;
+  outFlowCategories
+    << "Business" << "Charitable" << "Clothing" << "Debt" << "Food" << "Health"
+    << "Housing" << "Insurance" << "Personal" << "Recreation" << "Savings"
+    << "Taxes" << "Transportation" << "Travel" << "Utilities";
+
+  foreach(QString outFlowCategory, outFlowCategories) {
+    query.addBindValue(getNewPrimaryKeyId().toLongLong());
+    query.addBindValue(outFlowCategory);
+    query.addBindValue(outFlowId.toLongLong());
+    query.exec();
+  }
+}
+
+void Data::prepopulateItemTable() {
+  // one prepared statement serves every default item
+  QSqlQuery query;
+  query.prepare(
+    "insert into item(\n"
+    "  id\n"
+    "  , name\n"
+    "  , categoryId)\n"
+    "select\n"
+    "  ?\n"
+    "  , ?\n"
+    "  , cat.id\n"
+    "from\n"
+    "  flow flo\n"
+    "  join category cat\n"
+    "    on cat.flowId = flo.id\n"
+    "where\n"
+    "  flo.name = ?\n"
+    "  and cat.name = ?\n");
+
+  // initialize default items
+  insertItem(query, "In", "Gift", "Anniversary Gift");
+  insertItem(query, "In", "Gift", "Birthday Gift");
+  insertItem(query, "In", "Gift", "Christmas Gift");
+  insertItem(query, "In", "Gift", "Easter Gift");
+  insertItem(query, "In", "Gift", "Fathers Day Gift");
+  insertItem(query, "In", "Gift", "Mothers Day Gift");
+  insertItem(query, "In", "Gift", "Holiday Gift");
+  insertItem(query, "In", "Gift", "Congratulations Gift");
+  insertItem(query, "In", "Property Sales", "Misc. Property Resale");
+  insertItem(query, "In", "Rebate", "Misc. Rebate");
+  insertItem(query, "In", "Refund", "Misc. Refund");
+  insertItem(query, "In", "Reimbursement", "Misc. Reimbursement");
+  insertItem(query, "In", "Salary", "Misc. Gross Pay");
+  insertItem(query, "In", "Salary", "Misc. Take Home Pay");
+  insertItem(query, "In", "Savings", "Appliance Fund");
+  insertItem(query, "In", "Savings", "Elective Surgery Fund");
+  insertItem(query, "In", "Savings", "Emergency Fund");
+  insertItem(query, "In", "Savings", "Furniture Fund");
+  insertItem(query, "In", "Savings", "Gift Fund");
+  insertItem(query, "In", "Savings", "Home Insurance Fund");
+  insertItem(query, "In", "Savings", "Home Repair Fund");
+  insertItem(query, "In", "Savings", "New Home Fund");
+  insertItem(query, "In", "Savings", "Next Month's Rent Fund");
+  insertItem(query, "In", "Savings", "Retirement Fund");
+  insertItem(query, "In", "Savings", "Spending Surplus Fund");
+  insertItem(query, "In", "Savings", "Vacation Fund");
+  insertItem(query, "In", "Savings", "Vehicle Insurance Fund");
+  insertItem(query, "In", "Savings", "Vehicle Maintenance Fund");
+  insertItem(query, "In", "Savings", "Vehicle Purchase Fund");
+  insertItem(query, "In", "Savings", "Vet Fund");
+  insertItem(query, "Out", "Food", "Dining Out");
+  insertItem(query, "Out", "Food", "Food Bill");
+  insertItem(query, "Out", "Food", "Grocery");
+  insertItem(query, "Out", "Utilities", "Electricity");
+  insertItem(query, "Out", "Utilities", "Gas");
+  insertItem(query, "Out", "Utilities", "Internet");
+  insertItem(query, "Out", "Utilities", "Phone");
+  insertItem(query, "Out", "Utilities", "TV");
+  insertItem(query, "Out", "Utilities", "Water");
+  insertItem(query, "Out", "Clothing", "Clothes");
+  insertItem(query, "Out", "Clothing", "Laundry And Tailoring");
+  insertItem(query, "Out", "Clothing", "Cleaning");
+  insertItem(query, "Out", "Housing", "Furniture");
+  insertItem(query, "Out", "Housing", "Kitchenware");
+  insertItem(query, "Out", "Housing", "Mortgage");
+  insertItem(query, "Out", "Housing", "Real-Estate Taxes");
+  insertItem(query, "Out", "Housing", "Rent");
+  insertItem(query, "Out", "Housing", "Renters Insurance");
+  insertItem(query, "Out", "Housing", "Repairs And Maintenance");
+  insertItem(query, "Out", "Housing", "Safe Deposit Box");
+  insertItem(query, "Out", "Housing", "Storage");
+  insertItem(query, "Out", "Health", "Allergist");
+  insertItem(query, "Out", "Health", "Chiropractor");
+  insertItem(query, "Out", "Health", "Dentist");
+  insertItem(query, "Out", "Health", "Doctor");
+  insertItem(query, "Out", "Health", "Eye Care");
+  insertItem(query, "Out", "Health", "Hospital");
+  insertItem(query, "Out", "Health", "Medicine");
+  insertItem(query, "Out", "Health", "Spa");
+  insertItem(query, "Out", "Transportation", "Auto Parts");
+  insertItem(query, "Out", "Transportation", "Bus Fair");
+  insertItem(query, "Out", "Transportation", "Car Wash");
+  insertItem(query, "Out", "Transportation", "Gas And Oil");
+  insertItem(query, "Out", "Transportation", "License And Registration");
+  insertItem(query, "Out", "Transportation", "Repairs And Tires");
+  insertItem(query, "Out", "Transportation", "Vehicle History");
+  insertItem(query, "Out", "Taxes", "Federal Income Tax");
+  insertItem(query, "Out", "Taxes", "Federal Medicare Tax");
+  insertItem(query, "Out", "Taxes", "Federal Oasdi Social Security");
+  insertItem(query, "Out", "Taxes", "Income Tax Preparation");
+  insertItem(query, "Out", "Taxes", "Property Tax");
+  insertItem(query, "Out", "Taxes", "State Income Tax");
+  insertItem(query, "Out", "Taxes", "Vehicle Tax");
+  insertItem(query, "Out", "Debt", "Misc");
+  insertItem(query, "Out", "Insurance", "Car Insurance");
+  insertItem(query, "Out", "Insurance", "Dental Insurance");
+  insertItem(query, "Out", "Insurance", "Disability Insurance");
+  insertItem(query, "Out", "Insurance", "Homeowners Insurance");
+  insertItem(query, "Out", "Insurance", "Medical Insurance");
+  insertItem(query, "Out", "Insurance", "Renters Insurance");
+  insertItem(query, "Out", "Insurance", "Term Life Insurance");
+  insertItem(query, "Out", "Insurance", "Travel Insurance");
+  insertItem(query, "Out", "Insurance", "Vision Insurance");
+  insertItem(query, "Out", "Savings", "401K");
+  insertItem(query, "Out", "Savings", "Auto Maintenance Fund");
+  insertItem(query, "Out", "Savings", "Car Insurance Payment Fund");
+  insertItem(query, "Out", "Savings", "Education");
+  insertItem(query, "Out", "Savings", "Elective Surgery");
+  insertItem(query, "Out", "Savings", "Emergency Fund");
+  insertItem(query, "Out", "Savings", "Flex Spending Account");
+  insertItem(query, "Out", "Savings", "Furniture Fund");
+  insertItem(query, "Out", "Savings", "Gift Fund");
+  insertItem(query, "Out", "Savings", "New Home Fund Standby");
+  insertItem(query, "Out", "Savings", "New Home Fund");
+  insertItem(query, "Out", "Savings", "Next Month's Rent");
+  insertItem(query, "Out", "Savings", "Retirement Fund Standby");
+  insertItem(query, "Out", "Savings", "Rothira");
+  insertItem(query, "Out", "Savings", "Spending Surplus");
+  insertItem(query, "Out", "Savings", "Used Vehicle Fund");
+  insertItem(query, "Out", "Savings", "Vacation");
+  insertItem(query, "Out", "Savings", "Vet Fund");
+  insertItem(query, "Out", "Charitible", "Donations Or Tithe");
+  insertItem(query, "Out", "Charitible", "Gifts");
+  insertItem(query, "Out", "Personal", "Cash");
+  insertItem(query, "Out", "Personal", "Convention");
+  insertItem(query, "Out", "Personal", "Firearm");
+  insertItem(query, "Out", "Personal", "Education");
+  insertItem(query, "Out", "Personal", "Gifts");
+  insertItem(query, "Out", "Personal", "Hair Care");
+  insertItem(query, "Out", "Personal", "Organization Dues");
+  insertItem(query, "Out", "Personal", "Pet Care");
+  insertItem(query, "Out", "Personal", "Sales");
+  insertItem(query, "Out", "Personal", "Shipping");
+  insertItem(query, "Out", "Personal", "Stationary");
+  insertItem(query, "Out", "Personal", "Subscriptions");
+  insertItem(query, "Out", "Personal", "Toiletries");
+  insertItem(query, "Out", "Personal", "Veterinarian");
+  insertItem(query, "Out", "Business", "Repairs And Maintenance");
+  insertItem(query, "Out", "Business", "Shipping");
+  insertItem(query, "Out", "Recreation", "Blow");
+  insertItem(query, "Out", "Recreation", "Books");
+  insertItem(query, "Out", "Recreation", "Computer");
+  insertItem(query, "Out", "Recreation", "Electronics");
+  insertItem(query, "Out", "Recreation", "Entertainment");
+  insertItem(query, "Out", "Recreation", "Games");
+  insertItem(query, "Out", "Recreation", "Movies");
+  insertItem(query, "Out", "Recreation", "Sports");
+  insertItem(query, "Out", "Travel", "Cleaning");
+  insertItem(query, "Out", "Travel", "Dining");
+  insertItem(query, "Out", "Travel", "Transportation");
+  insertItem(query, "Out", "Travel", "Groceries");
+  insertItem(query, "Out", "Travel", "Entertainment");
+  insertItem(query, "Out", "Travel", "Lodging");
+  insertItem(query, "Out", "Travel", "Tips");
+
+}
+
+void Data::insertItem(
+    QSqlQuery &query
+    , QString flowName
+    , QString categoryName
+    , QString itemName) {
+  query.addBindValue(getNewPrimaryKeyId().toLongLong());
+  query.addBindValue(itemName);
+  query.addBindValue(flowName);
+  query.addBindValue(categoryName);
+  query.exec();
+}
+
+//void Data::deleteItem(
+//    QString flowName, QString categoryName, QString itemName) {
+//  QString insertText(QString(
+//    "delete ite(\n"
+//    "from\n"
+//    "  flow flo\n"
+//    "  join category cat\n"
+//    "    on cat.flowId = flo.id\n"
+//    "  join item ite\n"
+//    "    on ite.categoryId = cat.id\n"
+//    "where\n"
+//    "  flo.name = '%1'\n"
+//    "  and cat.name = '%2'\n"
+//    "  and ite.name = '%3'\n")
+//    .arg(flowName)
+//    .arg(categoryName)
+//    .arg(itemName));
+//
+//  QSqlQuery query(insertText);
+//}
+
+void Data::prepopulatePermanentData() {
+  prepopulateFlowTable();
+}
+
+void Data::prepopulateMappableData() {
+  prepopulateCategoryTable();
+  prepopulateItemTable();
+}
+
+bool Data::clearEditableData() {
+  bool isRunningOkay = true;
+
+  QSqlQuery query;
+  query.exec(
+    "delete\n"
+    "from\n"
+    "  period\n");
+
+  if (isRunningOkay
+      && query.lastError().isValid()) {
+    QString message = "Invalid clear of period records.";
+    showWarning(
+			QObject::tr("Error Type=")
+				+ query.lastError().type()
+				+ " "
+				+ QObject::tr(message.toUtf8())
+      , ATLINE + ":" + query.lastError().text());
+
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    query.exec(
+      "delete\n"
+      "from\n"
+      "  register\n");
+  }
+
+  if (isRunningOkay
+      && query.lastError().isValid()) {
+    QString message = "Invalid clear of register records.";
+    showWarning(
+			QObject::tr("Error Type=")
+				+ query.lastError().type()
+				+ " "
+				+ QObject::tr(message.toUtf8())
+      , ATLINE + ":" + query.lastError().text());
+
+    isRunningOkay = false;
+  }
+
+  return isRunningOkay;
+}
+
+
+void Data::fillPeriodWithAllItems(QString period) {
+  QSqlQuery query;
+
+  // add all items for each period
+  query.exec(
+    "insert into register(\n"
+    "  periodId\n"
+    "  , itemId\n"
+    "  , budget\n"
+    "  , actual\n"
+    "  , note)\n"
+    "select\n"
+    "  per.id\n"
+    "  , ite.id\n"
+    "  , 0.00\n"
+    "  , 0.00\n"
+    "  , ''\n"
+    "from\n"
+    "  period per\n"
+    "  cross join item ite\n"
+    "where\n"
+    "  per.periodId = '" + period + "';\n");
+
+  if (!query.isValid()) {
+    QString message = "Invalid query.";
+    showWarning(
+			QObject::tr("Error Type=")
+				+ query.lastError().type()
+				+ " "
+				+ QObject::tr(message.toUtf8())
+      , ATLINE + ":" + query.lastError().text());
+  }
+}
+
+void Data::fillAllPeriodsWithAllItems() {
+  QSqlQuery query;
+
+  // add all items for each period
+  query.exec(
+    "insert into register(\n"
+    "  periodId\n"
+    "  , itemId\n"
+    "  , budget\n"
+    "  , actual)\n"
+    "select\n"
     "  per.id\n"
     "  , ite.id\n"
     "  , 0.00\n"
@@ -1933,9 +2806,8 @@ void Data::fillAllPeriodsWithAllItems() {
 
   if (!query.isValid()) {
     QString message = "Invalid query.";
-    QMessageBox::warning(
-			(QWidget *)0
-			, QObject::tr("Error Type=")
+    showWarning(
+			QObject::tr("Error Type=")
 				+ query.lastError().type()
 				+ " "
 				+ QObject::tr(message.toUtf8())
@@ -1948,12 +2820,7 @@ bool Data::connectToDatabase(QString fileName) {
 
   if (fileName.isEmpty()) {
     // prompt for the file name to open
-		fileName =
-      QFileDialog::getOpenFileName(
-        (QWidget *)0
-  			, tr("Connect")
-        , savedFileName
-        , tr("SQLite Database files (*.db *.dat *.cashflow)"));
+		fileName = promptForOpenFileName(tr("Connect"));
 
     if (fileName.isEmpty()) {
       isRunningOkay = false;
@@ -1967,7 +2834,19 @@ bool Data::connectToDatabase(QString fileName) {
   return isRunningOkay;
 }
 
-bool Data::openFile(QString openFileName) {
+QString Data::promptForOpenFileName(QString caption) {
+  return
+    QFileDialog::getOpenFileName(
+      (QWidget *)0
+      , caption
+      , savedFileName
+      , tr(
+        "Cashflow files (*.db *.dat *.cashflow *.cashflowz);;"
+        "SQLite Database files (*.db *.dat *.cashflow);;"
+        "Compressed cashflow files (*.cashflowz)"));
+}
+
+bool Data::copyOverWorkingFile(QString fileName) {
   bool isRunningOkay = true;
 
   QString connectionName;
@@ -1977,9 +2856,8 @@ bool Data::openFile(QString openFileName) {
   // open a block here to allow the removal of the default connection
   {
     if (!db.isValid()) {
-      QMessageBox::warning(
-  			(QWidget *)0
-  			, QObject::tr("Error Type=")
+      showWarning(
+  			QObject::tr("Error Type=")
   				+ db.lastError().type()
   				+ " "
   				+ QObject::tr("Invalid database.")
@@ -1992,12 +2870,12 @@ bool Data::openFile(QString openFileName) {
 
   	// close the current database connection
     if (isRunningOkay) {
+      undoLog.clear();
   		db.close();
 
   		if (!db.isValid()) {
-  			QMessageBox::warning(
-  				(QWidget *)0
-  				, QObject::tr("Error Type=")
+  			showWarning(
+  				QObject::tr("Error Type=")
   					+ db.lastError().type()
   					+ " "
   					+ QObject::tr("Could not close the current database.")
@@ -2021,17 +2899,29 @@ bool Data::openFile(QString openFileName) {
 		// release the current file and grab a new one, temporarily
     workingDatabaseFile.reset(new QTemporaryFile());
 
-    // copy the open file over the working file
-    if (!QFile::copy(openFileName, workingDatabaseFileName)) {
-      QMessageBox::warning(
-				(QWidget *)0
-				, QObject::tr("Error: File not opened.")
+    // copy the open file over the working file, unpacking the compressed
+    // container a block at a time straight into it
+    bool isCopied =
+      (CompressedFile::isCompressed(fileName)
+      ? CompressedFile::uncompress(fileName, workingDatabaseFileName)
+      : QFile::copy(fileName, workingDatabaseFileName));
+
+    if (!isCopied) {
+      showWarning(
+				QObject::tr("Error: File not opened.")
 				, QObject::tr("The file could not be opened."));
 
       isRunningOkay = false;
     }
   }
 
+  // copies of resources are read-only, and the working file is written to
+  if (isRunningOkay) {
+    QFile::setPermissions(
+      workingDatabaseFileName
+      , QFile::ReadOwner | QFile::WriteOwner);
+  }
+
   // open a new database connection
 	if (isRunningOkay) {
 //		db = QSqlDatabase::addDatabase("QSQLITE");
@@ -2057,9 +2947,8 @@ bool Data::openFile(QString openFileName) {
 		db.setDatabaseName(workingDatabaseFile->fileName());
 
 		if (!db.open()) {
-			QMessageBox::warning(
-				(QWidget *)0
-				, QObject::tr("Could not open existing database.")
+			showWarning(
+				QObject::tr("Could not open existing database.")
 				, QObject::tr("Error Type=")
 					+ db.lastError().type()
 					+ " "
@@ -2069,10 +2958,267 @@ bool Data::openFile(QString openFileName) {
 		}
   }
 
-  if (isRunningOkay) {
-    // set the inFlowId value to the loaded one
-    QSqlQuery query(
-      "select\n"
+  return isRunningOkay;
+}
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+bool Data::backupIntoWorkingFile(QString fileName) {
+  bool isRunningOkay = true;
+
+  sqlite3 *destination = workingConnection();
+
+  if (destination == 0) {
+		showWarning(
+			QObject::tr("Error: File not opened.")
+			, QObject::tr("The working database connection is not available."));
+
+    isRunningOkay = false;
+  }
+
+  sqlite3 *source = 0;
+
+  if (isRunningOkay
+      && sqlite3_open_v2(
+        fileName.toUtf8().constData()
+        , &source
+        , SQLITE_OPEN_READONLY
+        , 0) != SQLITE_OK) {
+		showWarning(
+			QObject::tr("Error: File not opened.")
+			, QObject::tr("The file could not be opened.")
+        + "\n" + sqlite3_errmsg(source));
+
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    QString errorText = "";
+
+    isRunningOkay =
+      copyPages(
+        destination
+        , source
+        , QObject::tr("Opening file ...")
+        , errorText);
+
+    if (!isRunningOkay
+        && !errorText.isEmpty()) {
+  		showWarning(
+  			QObject::tr("Error: File not opened.")
+  			, QObject::tr("The file could not be copied.") + "\n" + errorText);
+    }
+  }
+
+  // a failed open still allocates a connection that has to be closed
+  if (source != 0) {
+    sqlite3_close(source);
+  }
+
+  return isRunningOkay;
+}
+#endif
+
+bool Data::openDatabaseCopy(QString fileName) {
+  bool isRunningOkay = true;
+
+  // the working file is about to be replaced, so let a running save finish
+  // and drop the autosave of the work being left
+  finishSave();
+  removeAutosaveFile();
+
+  // a file read in place gives way to a fresh working file first
+  if (readOnly) {
+    closeReadOnlyFile();
+  }
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+  // saved files are copied page by page into the open working connection,
+  // while resources and compressed files, which sqlite cannot open, are
+  // still copied as files, as is any file for a command-line export, which
+  // has no window for the progress dialog; a WAL file only takes pages of its own size, so
+  // leave WAL for the copy, and when a model is still reading and that
+  // fails, copy the file instead
+  bool isOutOfWal = false;
+
+  if (!fileName.startsWith(":")
+      && !CompressedFile::isCompressed(fileName)
+      && QApplication::type() != QApplication::Tty
+      && QSqlDatabase::database().isOpen()) {
+    QSqlQuery query;
+    query.exec("pragma journal_mode = delete;\n");
+
+    isOutOfWal = query.next() && query.value(0).toString() == "delete";
+  }
+
+  if (isOutOfWal) {
+    isRunningOkay = backupIntoWorkingFile(fileName);
+  } else {
+    isRunningOkay = copyOverWorkingFile(fileName);
+  }
+#else
+  isRunningOkay = copyOverWorkingFile(fileName);
+#endif
+
+  // the pragmas belong to the connection, so set them again on each reopen;
+  // a copy of the template starts a new file and takes the page size too
+  if (isRunningOkay) {
+    applyConnectionProfile(fileName == databaseTemplate);
+  }
+
+  if (isRunningOkay) {
+    // bring files from older versions up to the current structure
+    isRunningOkay = upgradeDatabaseStructure();
+  }
+
+  if (isRunningOkay) {
+    isRunningOkay = loadFlowIds();
+  }
+
+  if (isRunningOkay) {
+    loadLastPrimaryKeyId();
+
+    isRunningOkay =
+      reloadMetricsCache()
+      && undoLog.load();
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::openReadOnly(QString fileName) {
+  bool isRunningOkay = true;
+
+  if (fileName.isEmpty()) {
+    fileName = promptForOpenFileName(tr("Open Read-Only"));
+
+    isRunningOkay = !fileName.isEmpty();
+  }
+
+  if (isRunningOkay) {
+    // the work being left is not saved by a read-only file, so finish with
+    // it the way an open does
+    finishSave();
+    removeAutosaveFile();
+  }
+
+  bool isInPlace = false;
+
+  if (isRunningOkay
+      && !CompressedFile::isCompressed(fileName)) {
+    isInPlace = openInPlace(fileName);
+  }
+
+  // compressed files, files from older versions and files left in WAL are
+  // read through a working copy as usual, which is then held to reads
+  if (isRunningOkay
+      && !isInPlace) {
+    isRunningOkay = openDatabaseCopy(fileName);
+
+    if (isRunningOkay) {
+      QSqlQuery query;
+      query.exec("pragma query_only = 1;\n");
+
+      readOnly = true;
+    }
+  }
+
+  if (isRunningOkay) {
+    savedFileName = fileName;
+
+    setDataModified(false);
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::isReadOnly() const {
+  return readOnly;
+}
+
+bool Data::openInPlace(QString fileName) {
+  bool isRunningOkay = true;
+
+  // the default connection reads the saved file itself, so there is no copy
+  // to make and no working file left behind
+  QSqlDatabase db =
+    QSqlDatabase::database(QSqlDatabase::defaultConnection, false);
+
+  undoLog.clear();
+  db.close();
+  db.setConnectOptions("QSQLITE_OPEN_READONLY");
+  db.setDatabaseName(fileName);
+
+  readOnly = true;
+
+  isRunningOkay = db.open();
+
+  // a WAL file needs its shared memory written to even for reads, and an
+  // older file needs its upgrade, so both are left to the working copy
+  if (isRunningOkay) {
+    QSqlQuery query;
+
+    isRunningOkay =
+      query.exec("pragma journal_mode;\n")
+      && query.next()
+      && query.value(0).toString() != "wal";
+  }
+
+  if (isRunningOkay) {
+    isRunningOkay = (databaseVersion() == currentDatabaseVersion);
+  }
+
+  if (isRunningOkay) {
+    QSqlQuery query;
+    query.exec(
+      "PRAGMA query_only=1;");
+    query.exec(
+      "PRAGMA cache_size=" + QString::number(-cacheSizeKiB) + ";");
+    query.exec(
+      "PRAGMA mmap_size=" + QString::number(mmapSize) + ";");
+    query.exec(
+      "PRAGMA temp_store=MEMORY;");
+
+    isRunningOkay = loadFlowIds();
+  }
+
+  if (isRunningOkay) {
+    loadLastPrimaryKeyId();
+
+    isRunningOkay =
+      reloadMetricsCache()
+      && undoLog.load();
+  }
+
+  if (isRunningOkay) {
+    // the working file of the work left behind is no longer needed
+    workingDatabaseFile.reset();
+  } else {
+    closeReadOnlyFile();
+  }
+
+  return isRunningOkay;
+}
+
+void Data::closeReadOnlyFile() {
+  QSqlDatabase db =
+    QSqlDatabase::database(QSqlDatabase::defaultConnection, false);
+
+  undoLog.clear();
+  db.close();
+  db.setConnectOptions();
+
+  readOnly = false;
+
+  createNewDatabaseFile();
+}
+
+bool Data::loadFlowIds() {
+  bool isRunningOkay = true;
+
+  if (isRunningOkay) {
+    // set the inFlowId value to the loaded one
+    QSqlQuery query(
+      "select\n"
       "  id\n"
       "from\n"
       "  flow\n"
@@ -2082,9 +3228,8 @@ bool Data::openFile(QString openFileName) {
     if (query.next()) {
       inFlowId = query.value(0).toString();
     } else {
-			QMessageBox::warning(
-				(QWidget *)0
-				, QObject::tr("Could not get loaded In flow id.")
+			showWarning(
+				QObject::tr("Could not get loaded In flow id.")
 				, QObject::tr("The In flow id from the opened file is missing."));
 
 			isRunningOkay = false;
@@ -2097,436 +3242,1511 @@ bool Data::openFile(QString openFileName) {
       "select\n"
       "  id\n"
       "from\n"
-      "  flow\n"
+      "  flow\n"
+      "where\n"
+      "  name = 'Out'\n");
+
+    if (query.next()) {
+      outFlowId = query.value(0).toString();
+    } else {
+			showWarning(
+				QObject::tr("Could not get loaded Out flow id.")
+				, QObject::tr("The Out flow id from the opened file is missing."));
+
+			isRunningOkay = false;
+		}
+  }
+
+  return isRunningOkay;
+}
+
+QStringList Data::leftoverWorkingFiles() const {
+  QStringList fileNames;
+
+  // working files are named by QTemporaryFile from the template, and a
+  // clean exit removes them, so any but this session's were left by a crash
+  QRegExp workingFileName(QRegExp::escape(fileTemplate) + "\\.\\w{6}");
+
+  QFileInfoList candidates =
+    QDir::home().entryInfoList(
+      QStringList() << fileTemplate + ".*"
+      , QDir::Files
+      , QDir::Time);
+
+  foreach (QFileInfo candidate, candidates) {
+    if (workingFileName.exactMatch(candidate.fileName())
+        && (workingDatabaseFile.isNull()
+          || candidate.absoluteFilePath()
+            != QFileInfo(workingDatabaseFile->fileName()).absoluteFilePath())
+        && candidate.size() > 0
+        && releaseWorkingFile(candidate.absoluteFilePath())) {
+      fileNames << candidate.absoluteFilePath();
+    }
+  }
+
+  return fileNames;
+}
+
+bool Data::recoverWorkingFile(QString fileName) {
+  bool isRunningOkay = openDatabaseCopy(fileName);
+
+  if (isRunningOkay) {
+    // the recovered work has never been saved under any name
+    clearSavedDatabaseName();
+
+    setDataModified(true);
+
+    discardWorkingFile(fileName);
+  }
+
+  return isRunningOkay;
+}
+
+void Data::discardWorkingFile(QString fileName) {
+  QFile::remove(fileName);
+  QFile::remove(fileName + "-wal");
+  QFile::remove(fileName + "-shm");
+  QFile::remove(fileName + autosaveFileSuffix);
+}
+
+bool Data::openFile(QString openFileName) {
+  bool isRunningOkay = true;
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+  // a saved file is read in place while the save thread copies it into the
+  // working file, so it shows at once and takes edits when the copy is done
+  bool isInPlace = false;
+
+  if (!openFileName.startsWith(":")
+      && !CompressedFile::isCompressed(openFileName)) {
+    finishSave();
+    removeAutosaveFile();
+
+    isInPlace = openInPlace(openFileName);
+  }
+
+  // the file is open either way, and only editing waits on the copy
+  if (isInPlace) {
+    startWorkingCopy(openFileName);
+  } else {
+    isRunningOkay = openDatabaseCopy(openFileName);
+  }
+#else
+  isRunningOkay = openDatabaseCopy(openFileName);
+#endif
+
+  if (isRunningOkay) {
+    // set the current file name to the opened one
+    savedFileName = openFileName;
+
+    setDataModified(false);
+  }
+
+  return isRunningOkay;
+}
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+void Data::startWorkingCopy(QString fileName) {
+  createWorkingFile();
+
+  if (workingDatabaseFile->exists()) {
+    saveWorker.setJob(
+      fileName
+      , workingDatabaseFile->fileName()
+      , SaveWorker::WorkingCopy
+      , 0);
+
+    saveWorker.start(QThread::LowPriority);
+
+    savePending = true;
+  } else {
+    showWarning(
+      QObject::tr("Error: File not copied.")
+      , QObject::tr(
+        "The working file could not be created, so the file stays open "
+        "read-only."));
+  }
+}
+
+bool Data::openWorkingCopy() {
+  bool isRunningOkay = true;
+
+  // the file read in place gives way to its copy, which holds the same
+  // data, so only the connection and what was prepared on it change
+  QSqlDatabase db =
+    QSqlDatabase::database(QSqlDatabase::defaultConnection, false);
+
+  undoLog.clear();
+  db.close();
+  db.setConnectOptions();
+  db.setDatabaseName(workingDatabaseFile->fileName());
+
+  readOnly = false;
+
+  if (!db.open()) {
+    showWarning(
+      QObject::tr("Could not open existing database.")
+      , QObject::tr("Error Type=")
+        + db.lastError().type()
+        + " "
+        + db.lastError().text());
+
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    applyConnectionProfile(false);
+
+    isRunningOkay =
+      reloadMetricsCache()
+      && undoLog.load();
+  }
+
+  return isRunningOkay;
+}
+#endif
+
+bool Data::save(qint64 logUndoRedoIndex) {
+  bool isRunningOkay = true;
+
+  if (savedFileName.isEmpty()) {
+    // perform a save-as operation if still using the working file
+    isRunningOkay = saveAs(logUndoRedoIndex);
+  } else {
+    // save the current file
+    isRunningOkay =
+      startSave(savedFileName, SaveWorker::SaveFile, logUndoRedoIndex);
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::saveAs(qint64 logUndoRedoIndex) {
+  bool isRunningOkay = true;
+
+  // prompt for the new file name
+  QString newFileName = promptForSaveFileName(tr("Save As"));
+
+  isRunningOkay = !newFileName.isEmpty();
+
+  // the saved file name is stored once the save finishes
+  if (isRunningOkay) {
+    isRunningOkay =
+      startSave(newFileName, SaveWorker::SaveFile, logUndoRedoIndex);
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::backupAs(qint64 logUndoRedoIndex) {
+  bool isRunningOkay = true;
+
+  // prompt for the new file name
+  QString newFileName = promptForSaveFileName(tr("Clone As"));
+
+  isRunningOkay = !newFileName.isEmpty();
+
+  // attempt a file save operation
+  if (isRunningOkay) {
+    isRunningOkay =
+      startSave(newFileName, SaveWorker::BackupFile, logUndoRedoIndex);
+  }
+
+  return isRunningOkay;
+}
+
+QString Data::promptForSaveFileName(QString caption) {
+  QString compressedFilter = tr("Compressed cashflow files (*.cashflowz)");
+  QString selectedFilter;
+
+  QString fileName =
+    QFileDialog::getSaveFileName(
+      (QWidget *)0
+      , caption
+      , QDir::homePath() + QDir::toNativeSeparators("/untitled.cashflow")
+      , tr("SQLite Database files (*.db *.dat *.cashflow)")
+        + ";;" + compressedFilter
+      , &selectedFilter);
+
+  // the save writes the compressed container for names with its suffix
+  if (!fileName.isEmpty()
+      && selectedFilter == compressedFilter) {
+    fileName = CompressedFile::withCompressedSuffix(fileName);
+  }
+
+  return fileName;
+}
+
+bool Data::autosave(qint64 logUndoRedoIndex) {
+  return startSave(
+    autosaveFileName()
+    , SaveWorker::AutosaveFile
+    , logUndoRedoIndex);
+}
+
+bool Data::startSave(
+    QString saveFileName
+    , SaveWorker::Purpose purpose
+    , qint64 logUndoRedoIndex) {
+  bool isRunningOkay = true;
+
+  // a file opened read-only is never written, not even to a copy
+  if (readOnly) {
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    // saves run one at a time, so a new one waits out the last
+    finishSave();
+
+    // give back free pages once enough of the file has gone unused
+    cleanDatabase();
+  }
+
+#ifndef CASHFLOW_SQLITE_BACKUP
+  if (isRunningOkay) {
+    // the thread copies the file itself, so move the WAL into it and keep
+    // it from changing until the copy is done; edits meanwhile stay in the
+    // WAL
+    QSqlQuery query;
+    query.exec("pragma wal_autocheckpoint = 0;\n");
+
+    // the row is (busy, log, checkpointed), and a copy of the file alone is
+    // only whole once every frame of the log has been moved into it
+    isRunningOkay =
+      query.exec("pragma wal_checkpoint;\n")
+      && query.next()
+      && query.value(0).toInt() == 0
+      && query.value(1).toInt() == query.value(2).toInt();
+
+    query.finish();
+
+    if (!isRunningOkay) {
+      query.exec(
+        "pragma wal_autocheckpoint = "
+        + QString::number(walAutoCheckpointPages)
+        + ";\n");
+
+      // a failed autosave is tried again on the next tick without a message
+      if (purpose != SaveWorker::AutosaveFile) {
+    		showWarning(
+    			QObject::tr("Error: File not saved.")
+    			, QObject::tr(
+    			  "The database is busy and its changes could not be moved "
+    			  "into the file. Please try the save again."));
+      }
+    }
+  }
+#endif
+
+  if (isRunningOkay) {
+    saveWorker.setJob(
+      workingDatabaseFile->fileName()
+      , saveFileName
+      , purpose
+      , logUndoRedoIndex);
+
+    saveWorker.start(QThread::LowPriority);
+
+    savePending = true;
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::finishSave() {
+  bool isRunningOkay = savePending;
+
+  if (isRunningOkay) {
+    saveWorker.wait();
+
+    savePending = false;
+
+#ifndef CASHFLOW_SQLITE_BACKUP
+    QSqlQuery query;
+    query.exec(
+      "pragma wal_autocheckpoint = "
+      + QString::number(walAutoCheckpointPages)
+      + ";\n");
+#endif
+
+    isRunningOkay = saveWorker.isSaved();
+
+    if (!isRunningOkay
+        && saveWorker.purpose() == SaveWorker::WorkingCopy) {
+  		showWarning(
+  			QObject::tr("Error: File not copied.")
+  			, QObject::tr(
+  			  "The file could not be copied to edit, so it stays open "
+  			  "read-only.")
+  			  + "\n" + saveWorker.errorText());
+    }
+    // a failed autosave is tried again on the next tick without a message
+    else if (!isRunningOkay
+        && saveWorker.purpose() != SaveWorker::AutosaveFile) {
+  		showWarning(
+  			QObject::tr("Error: File not saved.")
+  			, saveWorker.errorText());
+    }
+  }
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+  // the file was read in place while it was copied, and edits go to the copy
+  if (isRunningOkay
+      && saveWorker.purpose() == SaveWorker::WorkingCopy) {
+    isRunningOkay = openWorkingCopy();
+  }
+#endif
+
+  if (isRunningOkay
+      && saveWorker.purpose() == SaveWorker::SaveFile) {
+    // the last autosave is stale once the work is saved, under either name
+    removeAutosaveFile();
+
+    // if the save worked, store the last saved file name
+    savedFileName = saveWorker.fileName();
+
+    removeAutosaveFile();
+
+    setDataModified(false);
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::isSaving() const {
+  return savePending;
+}
+
+QString Data::autosaveFileName() const {
+  return (
+    savedFileName.isEmpty()
+    ? workingDatabaseFile->fileName()
+    : savedFileName)
+    + autosaveFileSuffix;
+}
+
+void Data::removeAutosaveFile() {
+  // a file opened read-only has no autosave, and the one named after it
+  // belongs to a session that edited it
+  if (!readOnly
+      && !workingDatabaseFile.isNull()
+      && QFile::exists(autosaveFileName())) {
+    QFile::remove(autosaveFileName());
+  }
+}
+
+void Data::cleanDatabase() {
+  QSqlQuery query;
+
+  query.exec("pragma auto_vacuum;\n");
+
+  int autoVacuum = (query.next() ? query.value(0).toInt() : 0);
+
+  // files from before incremental auto vacuum need one full vacuum to
+  // switch over, after which saves only give back the free pages
+  if (autoVacuum != incrementalAutoVacuum) {
+    query.exec("pragma auto_vacuum = incremental;\n");
+    query.exec("vacuum;\n");
+  } else {
+    query.exec("pragma freelist_count;\n");
+    int freePageCount = (query.next() ? query.value(0).toInt() : 0);
+
+    query.exec("pragma page_count;\n");
+    int pageCount = (query.next() ? query.value(0).toInt() : 0);
+
+    if (pageCount > 0
+        && freePageCount > reclaimFreePageRatio * pageCount) {
+      // each step of the pragma frees one page, so run it to the end
+      query.exec("pragma incremental_vacuum;\n");
+
+      while (query.next()) {
+        // intentionally empty loop
+      }
+    }
+  }
+}
+
+QString Data::uniqueSuffix() {
+  QString dateTime = QString::number(QDateTime::currentMSecsSinceEpoch());
+
+  dateTime.replace(":", "_");
+  dateTime.replace("+", "p");
+
+  return dateTime;
+}
+
+bool Data::categoryHasItems(QString categoryId) {
+  QSqlQuery query;
+  query.prepare(
+    "select\n"
+    "  count(*)\n"
+    "from\n"
+    "  item\n"
+    "where\n"
+    "  categoryId = ?\n");
+  query.addBindValue(categoryId);
+  query.exec();
+
+  int itemCount = 0;
+
+  if (query.next()) {
+    itemCount = query.value(0).toInt();
+  }
+
+  return itemCount > 0;
+}
+
+bool Data::itemInRegister(QString itemId) {
+  QSqlQuery query;
+  query.prepare(
+    "select\n"
+    "  count(*)\n"
+    "from\n"
+    "  register\n"
+    "where\n"
+    "  itemId = ?\n");
+  query.addBindValue(itemId);
+  query.exec();
+
+  int registeredItemCount = 0;
+
+  if (query.next()) {
+    registeredItemCount = query.value(0).toInt();
+  }
+
+  return registeredItemCount > 0;
+}
+
+QString Data::getInFlowId() const {
+  return inFlowId;
+}
+
+QString Data::getOutFlowId() const {
+  return outFlowId;
+}
+
+QString Data::getNewPrimaryKeyId() const {
+  // milliseconds since the epoch in the high bits keep new rows at the end of
+  // each table's b-tree, and the low bits count ids within one millisecond
+  qint64 id = QDateTime::currentMSecsSinceEpoch() << primaryKeySequenceBits;
+
+  if (id <= lastPrimaryKeyId) {
+    id = lastPrimaryKeyId + 1;
+  }
+
+  lastPrimaryKeyId = id;
+
+  return QString::number(id);
+}
+
+void Data::loadLastPrimaryKeyId() {
+  // never hand out an id below one already in the file, even if the clock
+  // has moved backwards since it was written
+  QSqlQuery query(
+    "select\n"
+    "  max(id)\n"
+    "from (\n"
+    "  select max(id) as id from period\n"
+    "  union all\n"
+    "  select max(id) from flow\n"
+    "  union all\n"
+    "  select max(id) from category\n"
+    "  union all\n"
+    "  select max(id) from item\n"
+    "  union all\n"
+    "  select max(id) from register)\n");
+
+  if (query.next()) {
+    lastPrimaryKeyId = qMax(lastPrimaryKeyId, query.value(0).toLongLong());
+  }
+}
+
+qint64 Data::logUndoRedoCount() {
+  return undoLog.count();
+}
+
+bool Data::undo(qint64 firstIndex, qint64 lastIndex) {
+  return undoLog.undo(firstIndex, lastIndex);
+}
+
+bool Data::redo(qint64 firstIndex, qint64 lastIndex) {
+  return undoLog.redo(firstIndex, lastIndex);
+}
+
+qint64 Data::undoGroupStart(qint64 lastIndex) const {
+  return undoLog.groupStart(lastIndex);
+}
+
+qint64 Data::redoGroupEnd(qint64 firstIndex) const {
+  return undoLog.groupEnd(firstIndex);
+}
+
+bool Data::beginUndoGroup() {
+  return undoLog.beginGroup();
+}
+
+bool Data::endUndoGroup() {
+  return undoLog.endGroup();
+}
+
+bool Data::deleteFromLogUndoRedo(
+    qint64 firstIndex, qint64 endIndex) {
+  bool isRunningOkay = true;
+
+	if (firstIndex == 0
+			|| firstIndex > endIndex
+      || endIndex > logUndoRedoCount()) {
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    isRunningOkay = undoLog.remove(firstIndex, endIndex);
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::coalesceLogUndoRedo(qint64 index, int windowMilliseconds) {
+  return undoLog.coalesce(index, windowMilliseconds);
+}
+
+qint64 Data::compactLogUndoRedo(
+    qint64 lastIndex, int horizonDays, int maxEntries) {
+  // 0 turns either limit off
+  qint64 loggedBefore = 0;
+
+  if (horizonDays > 0) {
+    loggedBefore =
+      QDateTime::currentDateTime().addDays(-horizonDays).toMSecsSinceEpoch();
+  }
+
+  qint64 maxCount = (maxEntries > 0 ? maxEntries : logUndoRedoCount());
+
+  return undoLog.compact(lastIndex, loggedBefore, maxCount);
+}
+
+void Data::setUndoCachedRecordCount(int cachedRecordCount) {
+  undoLog.setCachedRecordCount(cachedRecordCount);
+}
+
+qint64 Data::nThLogUndoRedoId(qint64 index) const {
+  return undoLog.entryId(index);
+}
+
+Cashflow::MetricsCache *Data::getMetricsCache() {
+  return &metricsCache;
+}
+
+Cashflow::SaveWorker *Data::getSaveWorker() {
+  return &saveWorker;
+}
+
+bool Data::reloadMetricsCache() {
+  return metricsCache.load();
+}
+
+bool Data::getDataModified() const {
+  return dataModified;
+}
+
+void Data::setDataModified(bool isDataModified) {
+  dataModified = isDataModified;
+}
+
+bool Data::clonePeriodAs(QString sourcePeriodId, QString periodId) {
+  bool isRunningOkay = true;
+
+  qint64 sourcePeriod = sourcePeriodId.toLongLong(&isRunningOkay);
+  qint64 period = 0;
+
+  if (isRunningOkay) {
+    period = periodId.toLongLong(&isRunningOkay);
+  }
+
+  // copy the source period's register rows and values in one statement
+  if (isRunningOkay) {
+    isRunningOkay = insertRegisterRows(
+      QString(
+        "insert into register(\n"
+        "  id\n"
+        "  , periodId\n"
+        "  , itemId\n"
+        "  , budget\n"
+        "  , actual\n"
+        "  , note)\n"
+        "select\n"
+        "  null\n"
+        "  , %1\n"
+        "  , reg.itemId\n"
+        "  , reg.budget\n"
+        "  , reg.actual\n"
+        "  , reg.note\n"
+        "from\n"
+        "  register reg\n"
+        "where\n"
+        "  reg.periodId = %2\n"
+        "order by\n"
+        "  reg.id\n")
+        .arg(period)
+        .arg(sourcePeriod)
+      , "Could not clone the period.");
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::generatePeriods(
+    QString sourcePeriodId
+    , QStringList periodNames
+    , bool copyBudgets
+    , bool zeroActuals
+    , bool clearNotes) {
+  bool isRunningOkay = true;
+
+  QSqlDatabase db = QSqlDatabase::database();
+
+  qint64 sourcePeriod = sourcePeriodId.toLongLong(&isRunningOkay);
+
+  if (periodNames.isEmpty()) {
+    isRunningOkay = false;
+  }
+
+  // the new periods come one after another from the id generator
+  QStringList periodIds;
+  QVariantList periodIdValues;
+  QVariantList periodNameValues;
+
+  if (isRunningOkay) {
+    foreach(QString periodName, periodNames) {
+      QString periodId = getNewPrimaryKeyId();
+
+      periodIds << periodId;
+      periodIdValues << periodId.toLongLong();
+      periodNameValues << periodName;
+    }
+  }
+
+  QString periodIdList = periodIds.join(", ");
+
+  // copy the source register into every new period in one statement, with
+  // the register ids left null to follow the largest one as in cloning
+  QString registerInsert = QString(
+    "insert into register(\n"
+    "  id\n"
+    "  , periodId\n"
+    "  , itemId\n"
+    "  , budget\n"
+    "  , actual\n"
+    "  , note)\n"
+    "select\n"
+    "  null\n"
+    "  , per.id\n"
+    "  , reg.itemId\n"
+    "  , %1\n"
+    "  , %2\n"
+    "  , %3\n"
+    "from\n"
+    "  period per\n"
+    "  cross join register reg\n"
+    "where\n"
+    "  per.id in (%4)\n"
+    "  and reg.periodId = %5\n"
+    "order by\n"
+    "  per.id\n"
+    "  , reg.id\n")
+    .arg(copyBudgets ? "reg.budget" : "0")
+    .arg(zeroActuals ? "0" : "reg.actual")
+    .arg(clearNotes ? "''" : "reg.note")
+    .arg(periodIdList)
+    .arg(sourcePeriod);
+
+  qint64 loggedCount = undoLog.count();
+
+  bool isInTransaction = false;
+
+  if (isRunningOkay) {
+    isInTransaction = db.transaction();
+
+    isRunningOkay = isInTransaction;
+  }
+
+  // the periods and their register rows undo together as one step, with
+  // the rows logged after their periods so an undo takes them out first
+  bool isInGroup = false;
+
+  if (isRunningOkay) {
+    isInGroup = undoLog.beginGroup();
+
+    isRunningOkay = isInGroup;
+  }
+
+  if (isRunningOkay) {
+    QSqlQuery query;
+    query.prepare(
+      "insert into period(\n"
+      "  id\n"
+      "  , name)\n"
+      "values(\n"
+      "  ?\n"
+      "  , ?)\n");
+    query.addBindValue(periodIdValues);
+    query.addBindValue(periodNameValues);
+
+    if (!query.execBatch()) {
+      showWarning(
+        QObject::tr("Error Type=")
+          + query.lastError().type()
+          + " "
+          + QObject::tr("Could not generate the periods.")
+        , ATLINE + ":" + query.lastError().text());
+
+      isRunningOkay = false;
+    }
+  }
+
+  if (isRunningOkay) {
+    isRunningOkay = undoLog.logRecords(
+      UndoLog::InsertOperation
+      , UndoLog::PeriodTable
+      , periodIdValues
+      , QList<QVariantList>()
+      , QList<QVariantList>() << periodNameValues);
+  }
+
+  qint64 firstRegisterId = 0;
+
+  if (isRunningOkay) {
+    firstRegisterId = maxRegisterId() + 1;
+
+    isRunningOkay =
+      executeStatements(
+        QStringList() << registerInsert
+        , "Could not generate the periods.");
+  }
+
+  if (isRunningOkay) {
+    isRunningOkay = logRegisterRows(
+      UndoLog::InsertOperation
+      , QString("  id between %1 and %2\n")
+        .arg(firstRegisterId)
+        .arg(maxRegisterId()));
+  }
+
+  if (isInGroup
+      && !undoLog.endGroup()) {
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    db.commit();
+    loadLastPrimaryKeyId();
+  } else if (isInTransaction) {
+    db.rollback();
+    undoLog.rollBackTo(loggedCount);
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::registerAllItems(QString periodId) {
+  bool isRunningOkay = true;
+
+  qint64 period = periodId.toLongLong(&isRunningOkay);
+
+  if (isRunningOkay) {
+    isRunningOkay = insertRegisterRows(
+      QString(
+        "insert into register(\n"
+        "  id\n"
+        "  , periodId\n"
+        "  , itemId\n"
+        "  , budget\n"
+        "  , actual\n"
+        "  , note)\n"
+        "select\n"
+        "  null\n"
+        "  , umv.periodId\n"
+        "  , umv.itemId\n"
+        "  , 0\n"
+        "  , 0\n"
+        "  , ''\n"
+        "from\n"
+        "  unusedMetricsView umv\n"
+        "where\n"
+        "  umv.periodId = %1\n"
+        "order by\n"
+        "  umv.itemId\n")
+        .arg(period)
+      , "Could not register all items.");
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::insertRegisterRows(QString insertStatement, QString message) {
+  bool isRunningOkay = true;
+
+  QSqlDatabase db = QSqlDatabase::database();
+
+  // the statement leaves the ids null, so the new rows take the integers
+  // after the largest register id in statement order, which keeps them at
+  // the end of the b-tree
+  qint64 firstRegisterId = 0;
+  qint64 lastRegisterId = 0;
+
+  qint64 loggedCount = undoLog.count();
+
+  bool isInTransaction = db.transaction();
+
+  isRunningOkay = isInTransaction;
+
+  // the new rows undo as one step
+  bool isInGroup = false;
+
+  if (isRunningOkay) {
+    isInGroup = undoLog.beginGroup();
+
+    isRunningOkay = isInGroup;
+  }
+
+  if (isRunningOkay) {
+    firstRegisterId = maxRegisterId() + 1;
+
+    QSqlQuery query;
+
+    if (!query.exec(insertStatement)) {
+      showWarning(
+        QObject::tr("Error Type=")
+          + query.lastError().type()
+          + " "
+          + QObject::tr(message.toUtf8())
+        , ATLINE + ":" + query.lastError().text());
+
+      isRunningOkay = false;
+    }
+  }
+
+  // nothing inserted logs nothing, and the empty group leaves nothing behind
+  if (isRunningOkay) {
+    lastRegisterId = maxRegisterId();
+
+    isRunningOkay = logRegisterRows(
+      UndoLog::InsertOperation
+      , QString("  id between %1 and %2\n")
+        .arg(firstRegisterId)
+        .arg(lastRegisterId));
+  }
+
+  if (isInGroup
+      && !undoLog.endGroup()) {
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    db.commit();
+    loadLastPrimaryKeyId();
+  } else if (isInTransaction) {
+    db.rollback();
+    undoLog.rollBackTo(loggedCount);
+  }
+
+  return isRunningOkay;
+}
+
+bool Data::logRegisterRows(UndoLog::Operation operation, QString condition) {
+  bool isRunningOkay = true;
+
+  // the rows are read back in rowColumns order, which an insert logs as its
+  // new values and a delete as its old ones
+  QVariantList rowIds;
+  QList<QVariantList> columns;
+
+  for (int column = 0; column < registerRowColumnCount; ++column) {
+    columns << QVariantList();
+  }
+
+  QSqlQuery query;
+  query.setForwardOnly(true);
+
+  if (!query.exec(
+      "select\n"
+      "  id\n"
+      "  , periodId\n"
+      "  , itemId\n"
+      "  , budget\n"
+      "  , actual\n"
+      "  , note\n"
+      "from\n"
+      "  register\n"
       "where\n"
-      "  name = 'Out'\n");
-
-    if (query.next()) {
-      outFlowId = query.value(0).toString();
-    } else {
-			QMessageBox::warning(
-				(QWidget *)0
-				, QObject::tr("Could not get loaded Out flow id.")
-				, QObject::tr("The Out flow id from the opened file is missing."));
+      + condition
+      + "order by\n"
+      "  id\n")) {
+    showWarning(
+      QObject::tr("Error Type=")
+        + query.lastError().type()
+        + " "
+        + QObject::tr("Could not read the changed register rows.")
+      , ATLINE + ":" + query.lastError().text());
 
-			isRunningOkay = false;
-		}
+    isRunningOkay = false;
   }
 
-  if (isRunningOkay) {
-    // set the current file name to the opened one
-    savedFileName = openFileName;
+  while (isRunningOkay && query.next()) {
+    rowIds << query.value(0);
 
-    setDataModified(false);
+    for (int column = 0; column < registerRowColumnCount; ++column) {
+      columns[column] << query.value(column + 1);
+    }
   }
 
-  return isRunningOkay;
-}
-
-bool Data::save() {
-  bool isRunningOkay = true;
+  query.finish();
 
-  if (savedFileName.isEmpty()) {
-    // perform a save-as operation if still using the working file
-    isRunningOkay = saveAs();
-  } else {
-    // save the current file
-    isRunningOkay = saveFile(savedFileName);
+  if (isRunningOkay) {
+    isRunningOkay = undoLog.logRecords(
+      operation
+      , UndoLog::RegisterTable
+      , rowIds
+      , (operation == UndoLog::DeleteOperation
+        ? columns
+        : QList<QVariantList>())
+      , (operation == UndoLog::InsertOperation
+        ? columns
+        : QList<QVariantList>()));
   }
 
   return isRunningOkay;
 }
 
-bool Data::saveAs() {
-  bool isRunningOkay = true;
+QStringList Data::changedRegisterItemNames(
+    QString periodId, int &registerCount) const {
+  QStringList itemNames;
 
-  // prompt for the new file name
-  QString newFileName =
-    QFileDialog::getSaveFileName(
-      (QWidget *)0
-      , tr("Save As")
-      , QDir::homePath() + QDir::toNativeSeparators("/untitled.cashflow")
-      , tr("SQLite Database files (*.db *.dat *.cashflow)"));
+  registerCount = 0;
+
+  // one pass over the period's register rows counts them and lists the
+  // ones with values that unregistering would lose
+  QSqlQuery query;
+  query.setForwardOnly(true);
+  query.prepare(
+    "select\n"
+    "  ite.name\n"
+    "  , reg.budget <> 0 or reg.actual <> 0 or reg.note <> ''\n"
+    "from\n"
+    "  register reg\n"
+    "  join item ite\n"
+    "    on ite.id = reg.itemId\n"
+    "where\n"
+    "  reg.periodId = ?\n"
+    "order by\n"
+    "  ite.name\n");
+  query.addBindValue(periodId.toLongLong());
+  query.exec();
 
-  isRunningOkay = saveFile(newFileName);
+  while (query.next()) {
+    ++registerCount;
 
-  if (isRunningOkay) {
-    // if the saved work, store the last saved file name
-    savedFileName = newFileName;
+    if (query.value(1).toBool()) {
+      itemNames << query.value(0).toString();
+    }
   }
 
-  return isRunningOkay;
+  return itemNames;
 }
 
-bool Data::backupAs() {
+bool Data::unregisterAllItems(QString periodId, bool includeChanged) {
   bool isRunningOkay = true;
 
-  // prompt for the new file name
-  QString newFileName =
-    QFileDialog::getSaveFileName(
-      (QWidget *)0
-      , tr("Clone As")
-      , QDir::homePath() + QDir::toNativeSeparators("/untitled.cashflow")
-      , tr("SQLite Database files (*.db *.dat *.cashflow)"));
+  QSqlDatabase db = QSqlDatabase::database();
 
-  // attempt a file save operation
-  isRunningOkay = saveFile(newFileName);
+  qint64 period = periodId.toLongLong(&isRunningOkay);
 
-  return isRunningOkay;
-}
+  QString condition = QString("  periodId = %1\n").arg(period);
 
-bool Data::saveFile(QString saveFileName) {
-  bool isRunningOkay = true;
+  if (!includeChanged) {
+    condition +=
+      "  and budget = 0\n"
+      "  and actual = 0\n"
+      "  and note = ''\n";
+  }
 
-  // clean up old, unused space in database
-  cleanDatabase();
+  qint64 loggedCount = undoLog.count();
 
-  // create fail-safe backup in case saveFileName exists
-  QString failSafeFileName = saveFileName + "." + uniqueSuffix();
+  bool isInTransaction = false;
 
-  // copy temporary backup if saveFileName exists, in case of failure
-  if (isRunningOkay
-      && QFile::exists(saveFileName)
-      && !QFile::copy(saveFileName, failSafeFileName)) {
-    isRunningOkay = false;
+  if (isRunningOkay) {
+    isInTransaction = db.transaction();
+
+    isRunningOkay = isInTransaction;
   }
 
-  // remove the current file so that copy will save over
-  if (isRunningOkay
-      && QFile::exists(saveFileName)
-      && !QFile::remove(saveFileName)) {
-    isRunningOkay = false;
+  // the deleted rows undo as one step, each put back from its own record
+  bool isInGroup = false;
+
+  if (isRunningOkay) {
+    isInGroup = undoLog.beginGroup();
+
+    isRunningOkay = isInGroup;
   }
 
-  // copy the working database file as the save file name
-  if (isRunningOkay
-      && !QFile::exists(saveFileName)
-      && workingDatabaseFile->exists()
-      && !workingDatabaseFile->copy(saveFileName)) {
-    isRunningOkay = false;
+  if (isRunningOkay) {
+    isRunningOkay = logRegisterRows(UndoLog::DeleteOperation, condition);
   }
 
-  // delete fail-safe backup if it and save file name exists
-  if (isRunningOkay
-      && QFile::exists(saveFileName)
-      && QFile::exists(failSafeFileName)
-      && !QFile::remove(failSafeFileName)) {
-    isRunningOkay = false;
+  if (isRunningOkay) {
+    QSqlQuery query;
+
+    if (!query.exec(
+        "delete\n"
+        "from\n"
+        "  register\n"
+        "where\n"
+        + condition)) {
+      showWarning(
+        QObject::tr("Error Type=")
+          + query.lastError().type()
+          + " "
+          + QObject::tr("Could not unregister all items.")
+        , ATLINE + ":" + query.lastError().text());
+
+      isRunningOkay = false;
+    }
   }
 
-  if (!isRunningOkay) {
+  if (isInGroup
+      && !undoLog.endGroup()) {
     isRunningOkay = false;
   }
 
   if (isRunningOkay) {
-    setDataModified(false);
+    db.commit();
+  } else if (isInTransaction) {
+    db.rollback();
+    undoLog.rollBackTo(loggedCount);
   }
 
   return isRunningOkay;
 }
 
-void Data::cleanDatabase() {
-  QSqlQuery query;
+QStringList Data::unmatchedPayees(QStringList payees) const {
+  QStringList unmatched;
 
-  // clean up the database
-  query.exec("vacuum;\n");
+  QList<QPair<QString, qint64> > rules = payeeRules();
 
-  // the following query validation step always returns false for vacuum
-//  if (!query.isValid()) {
-//    QString message = "Invalid query.";
-//    QMessageBox::warning(
-//			(QWidget *)0
-//			, QObject::tr("Error Type=")
-//				+ query.lastError().type()
-//				+ " "
-//				+ QObject::tr(message.toUtf8())
-//      , ATLINE + ":" + query.lastError().text());
-//  }
-}
+  foreach(QString payee, payees) {
+    if (matchPayeeRule(rules, payee) == 0) {
+      unmatched << payee;
+    }
+  }
 
-QString Data::uniqueSuffix() {
-  QString dateTime = QString::number(QDateTime::currentMSecsSinceEpoch());
+  return unmatched;
+}
 
-  dateTime.replace(":", "_");
-  dateTime.replace("+", "p");
+bool Data::addPayeeRules(QMap<QString, QString> itemIdsByPattern) {
+  bool isRunningOkay = true;
 
-  return dateTime;
-}
+  QSqlDatabase db = QSqlDatabase::database();
 
-bool Data::categoryHasItems(QString categoryId) {
-  QSqlQuery query(QString(
-    "select\n"
-    "  count(*)\n"
-    "from\n"
-    "  item\n"
-    "where\n"
-    "  categoryId = %1")
-      .arg(categoryId));
+  QVariantList patterns;
+  QVariantList itemIds;
 
-  int itemCount = 0;
+  QMap<QString, QString>::const_iterator iterator;
 
-  if (query.next()) {
-    itemCount = query.value(0).toInt();
+  for (iterator = itemIdsByPattern.constBegin();
+      iterator != itemIdsByPattern.constEnd();
+      ++iterator) {
+    patterns << iterator.key();
+    itemIds << iterator.value().toLongLong();
   }
 
-  return itemCount > 0;
-}
+  bool isInTransaction = false;
 
-bool Data::itemInRegister(QString itemId) {
-  QSqlQuery query(QString(
-    "select\n"
-    "  count(*)\n"
-    "from\n"
-    "  register\n"
-    "where\n"
-    "  itemId = %1")
-      .arg(itemId));
+  if (!patterns.isEmpty()) {
+    isInTransaction = db.transaction();
 
-  int registeredItemCount = 0;
+    // a pattern given again moves to the newly chosen item
+    QSqlQuery query;
+    query.prepare(
+      "insert or replace into payeeRule(\n"
+      "  pattern\n"
+      "  , itemId)\n"
+      "values(\n"
+      "  ?\n"
+      "  , ?)\n");
+    query.addBindValue(patterns);
+    query.addBindValue(itemIds);
+
+    if (!query.execBatch()) {
+      showWarning(
+        QObject::tr("Error Type=")
+          + query.lastError().type()
+          + " "
+          + QObject::tr("Invalid insert into payeeRule table.")
+        , ATLINE + ":" + query.lastError().text());
 
-  if (query.next()) {
-    registeredItemCount = query.value(0).toInt();
+      isRunningOkay = false;
+    }
   }
 
-  return registeredItemCount > 0;
-}
+  if (isRunningOkay) {
+    if (isInTransaction) {
+      db.commit();
+    }
+  } else if (isInTransaction) {
+    db.rollback();
+  }
 
-QString Data::getInFlowId() const {
-  return inFlowId;
+  return isRunningOkay;
 }
 
-QString Data::getOutFlowId() const {
-  return outFlowId;
-}
+bool Data::importStatement(
+    const QList<StatementReader::Total> &totals
+    , int &importedCount
+    , QStringList &missingPeriodNames) {
+  bool isRunningOkay = true;
 
-QString Data::getNewPrimaryKeyId() const {
-  return QUuid::createUuid().toString();
-}
+  QSqlDatabase db = QSqlDatabase::database();
 
-quint16 Data::logUndoRedoCount() const {
-  QSqlQuery query(QString(
-    "select\n"
-    "  count(*)\n"
-    "from\n"
-    "  logUndoRedo\n"));
+  importedCount = 0;
+  missingPeriodNames.clear();
 
-  int count = 0;
+  QList<QPair<QString, qint64> > rules = payeeRules();
 
-  if (query.next()) {
-    count = query.value(0).toInt();
+  // the statement months are matched to the periods by name
+  QHash<QString, qint64> periodIds;
+
+  {
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.exec(
+      "select\n"
+      "  id\n"
+      "  , name\n"
+      "from\n"
+      "  period\n"
+      "order by\n"
+      "  id\n");
+
+    while (query.next()) {
+      QString periodName = query.value(1).toString();
+
+      if (!periodIds.contains(periodName)) {
+        periodIds.insert(periodName, query.value(0).toLongLong());
+      }
+    }
   }
 
-  return count;
-}
+  // each payee is matched against the rules once, however many months it
+  // shows up in, and the totals are summed again per period and item
+  QHash<QString, qint64> itemIdsByPayee;
+  QMap<QPair<qint64, qint64>, qint64> amounts;
+  QMap<QPair<qint64, qint64>, qint64>::const_iterator iterator;
+  QSet<QString> missingPeriods;
 
-bool Data::undo(quint16 index) const {
-  bool isRunningOkay = true;
+  foreach(const StatementReader::Total &total, totals) {
+    if (!itemIdsByPayee.contains(total.payee)) {
+      itemIdsByPayee.insert(total.payee, matchPayeeRule(rules, total.payee));
+    }
 
-  // get the undo SQL
-  QSqlQuery query(QString(
-    "select\n"
-    "  undoCommand\n"
-    "from\n"
-    "  logUndoRedo\n"
-    "where\n"
-    "  id = %1\n")
-		.arg(nThLogUndoRedoId(index)));
+    qint64 itemId = itemIdsByPayee.value(total.payee);
 
-  QString undo = "";
+    if (itemId == 0) {
+      continue;
+    }
 
-  if (query.next()) {
-    undo = query.value(0).toString();
-  } else {
-    isRunningOkay = false;
+    if (!periodIds.contains(total.periodName)) {
+      missingPeriods << total.periodName;
+      continue;
+    }
+
+    amounts[qMakePair(periodIds.value(total.periodName), itemId)] +=
+      total.amount;
   }
 
-  // run the undo SQL
-  if (isRunningOkay) {
-    QStringList undoStringList = undo.split('\n');
-		undo = undoStringList.join(" ");
+  missingPeriodNames = missingPeriods.toList();
+  missingPeriodNames.sort();
+
+  if (amounts.isEmpty()) {
+    return isRunningOkay;
+  }
 
-		QSqlQuery undoQuery;
-		undoQuery.prepare(undo);
+  QSet<qint64> importPeriodIds;
 
-    if (!undoQuery.exec()) {
-      isRunningOkay = false;
-    }
+  for (iterator = amounts.constBegin();
+      iterator != amounts.constEnd();
+      ++iterator) {
+    importPeriodIds << iterator.key().first;
   }
 
-  return isRunningOkay;
-}
+  QStringList periodIdList;
 
-bool Data::redo(quint16 index) const {
-  bool isRunningOkay = true;
+  foreach(qint64 periodId, importPeriodIds) {
+    periodIdList << QString::number(periodId);
+  }
 
-  // get the redo SQL
-  QSqlQuery query(QString(
-    "select\n"
-    "  redoCommand\n"
-    "from\n"
-    "  logUndoRedo\n"
-    "where\n"
-    "  id = %1\n")
-		.arg(nThLogUndoRedoId(index)));
+  qint64 loggedCount = undoLog.count();
 
-  QString redo = "";
+  bool isInTransaction = db.transaction();
 
-  if (query.next()) {
-    redo = query.value(0).toString();
-  } else {
-    isRunningOkay = false;
+  isRunningOkay = isInTransaction;
+
+  // the new rows and the changed ones undo together as one step
+  bool isInGroup = false;
+
+  if (isRunningOkay) {
+    isInGroup = undoLog.beginGroup();
+
+    isRunningOkay = isInGroup;
   }
 
-  // run the redo SQL
+  // the oldest register row of an item in a period takes its actuals, and
+  // its values are kept for the undo log
+  QHash<QPair<qint64, qint64>, qint64> registerIds;
+  QHash<qint64, QVariantList> registerValues;
+
   if (isRunningOkay) {
-    QStringList redoStringList = redo.split('\n');
-		redo = redoStringList.join(" ");
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.exec(
+      "select\n"
+      "  id\n"
+      "  , periodId\n"
+      "  , itemId\n"
+      "  , budget\n"
+      "  , actual\n"
+      "  , note\n"
+      "from\n"
+      "  register\n"
+      "where\n"
+      "  periodId in (" + periodIdList.join(", ") + ")\n"
+      "order by\n"
+      "  id\n");
+
+    while (query.next()) {
+      QPair<qint64, qint64> key =
+        qMakePair(query.value(1).toLongLong(), query.value(2).toLongLong());
+
+      if (amounts.contains(key) && !registerIds.contains(key)) {
+        registerIds.insert(key, query.value(0).toLongLong());
+        registerValues.insert(
+          query.value(0).toLongLong()
+          , QVariantList()
+            << query.value(3)
+            << query.value(4)
+            << query.value(5));
+      }
+    }
+  }
 
-		QSqlQuery redoQuery;
-		redoQuery.prepare(redo);
+  // items not yet registered in a period get a row of their own, numbered
+  // after the largest register id the way the other bulk inserts are
+  qint64 nextRegisterId = maxRegisterId() + 1;
+
+  QVariantList insertIds;
+  QVariantList insertPeriodIds;
+  QVariantList insertItemIds;
+  QVariantList insertZeros;
+  QVariantList insertNotes;
+
+  // each changed row logs its budget, actual and note before and after
+  QVariantList updateAmounts;
+  QVariantList updateIds;
+  QList<QVariantList> oldColumns;
+  QList<QVariantList> newColumns;
+
+  for (int column = 0; column < registerEditColumnCount; ++column) {
+    oldColumns << QVariantList();
+    newColumns << QVariantList();
+  }
 
-		if (!redoQuery.exec()) {
-      isRunningOkay = false;
+  for (iterator = amounts.constBegin();
+      iterator != amounts.constEnd();
+      ++iterator) {
+    qint64 registerId = registerIds.value(iterator.key(), 0);
+
+    if (registerId == 0) {
+      registerId = nextRegisterId++;
+
+      insertIds << registerId;
+      insertPeriodIds << iterator.key().first;
+      insertItemIds << iterator.key().second;
+      insertZeros << 0;
+      insertNotes << "";
+
+      registerValues.insert(
+        registerId
+        , QVariantList() << 0 << 0 << "");
+    }
+
+    QVariantList values = registerValues.value(registerId);
+
+    updateAmounts << iterator.value();
+    updateIds << registerId;
+
+    for (int column = 0; column < registerEditColumnCount; ++column) {
+      oldColumns[column] << values.at(column);
     }
+
+    // the same values the update works out, so the log matches the row
+    qint64 actual = values.at(1).toLongLong() + iterator.value();
+
+    newColumns[0] << qMax(values.at(0).toLongLong(), actual);
+    newColumns[1] << actual;
+    newColumns[2] << values.at(2);
   }
 
-  return isRunningOkay;
-}
+  if (isRunningOkay
+      && !insertIds.isEmpty()) {
+    QSqlQuery query;
+    query.prepare(
+      "insert into register(\n"
+      "  id\n"
+      "  , periodId\n"
+      "  , itemId\n"
+      "  , budget\n"
+      "  , actual\n"
+      "  , note)\n"
+      "values(\n"
+      "  ?\n"
+      "  , ?\n"
+      "  , ?\n"
+      "  , 0\n"
+      "  , 0\n"
+      "  , '')\n");
+    query.addBindValue(insertIds);
+    query.addBindValue(insertPeriodIds);
+    query.addBindValue(insertItemIds);
+
+    if (!query.execBatch()) {
+      showWarning(
+        QObject::tr("Error Type=")
+          + query.lastError().type()
+          + " "
+          + QObject::tr("Could not register the imported items.")
+        , ATLINE + ":" + query.lastError().text());
 
-bool Data::deleteFromLogUndoRedo(
-    quint16 firstIndex, quint16 endIndex) {
-  bool isRunningOkay = true;
+      isRunningOkay = false;
+    }
+  }
 
-	if (firstIndex == 0
-			|| firstIndex > endIndex
-      || endIndex > logUndoRedoCount()) {
-    isRunningOkay = false;
+  if (isRunningOkay) {
+    isRunningOkay = undoLog.logRecords(
+      UndoLog::InsertOperation
+      , UndoLog::RegisterTable
+      , insertIds
+      , QList<QVariantList>()
+      , QList<QVariantList>()
+        << insertPeriodIds
+        << insertItemIds
+        << insertZeros
+        << insertZeros
+        << insertNotes);
   }
 
+  // one prepared statement adds every total, run as a batch; the budget
+  // rises to cover the new actual, since the register never holds an actual
+  // over its budget
   if (isRunningOkay) {
-    // get the redo SQL
-    QSqlQuery query(QString(
-      "delete\n"
-      "from\n"
-      "  logUndoRedo\n"
+    QSqlQuery query;
+    query.prepare(
+      "update register\n"
+      "set\n"
+      "  budget = max(budget, actual + ?)\n"
+      "  , actual = actual + ?\n"
       "where\n"
-      "  id between %1 and %2\n")
-      .arg(nThLogUndoRedoId(firstIndex))
-      .arg(nThLogUndoRedoId(endIndex)));
+      "  id = ?\n");
+    query.addBindValue(updateAmounts);
+    query.addBindValue(updateAmounts);
+    query.addBindValue(updateIds);
+
+    if (!query.execBatch()) {
+      showWarning(
+        QObject::tr("Error Type=")
+          + query.lastError().type()
+          + " "
+          + QObject::tr("Could not import the statement.")
+        , ATLINE + ":" + query.lastError().text());
 
-    if (!query.exec()) {
       isRunningOkay = false;
     }
   }
 
-  return isRunningOkay;
-}
-
-quint16 Data::nThLogUndoRedoId(quint16 index) const {
-  bool isRunningOkay = true;
+  if (isRunningOkay) {
+    isRunningOkay = undoLog.logRecords(
+      UndoLog::UpdateOperation
+      , UndoLog::RegisterTable
+      , updateIds
+      , oldColumns
+      , newColumns);
+  }
 
-	if (index == 0
-			|| index > logUndoRedoCount()) {
+  if (isInGroup
+      && !undoLog.endGroup()) {
     isRunningOkay = false;
   }
 
-	quint16 id = 0;
-
   if (isRunningOkay) {
-    QSqlQuery query(QString(
-      "select\n"
-      "  id\n"
-      "from\n"
-      "  logUndoRedo\n"
-      "order by\n"
-      "  id\n"));
+    db.commit();
+    loadLastPrimaryKeyId();
 
-		if (query.exec() && query.isSelect()
-				&& query.seek(index - 1) && query.isValid()) {
-			id = query.value(0).toInt();
-    } else {
-			QMessageBox::warning(
-				(QWidget *)0
-				, QObject::tr("Could not get undo log id.")
-				, QObject::tr("The undo log id is missing."));
-
-			isRunningOkay = false;
-		}
+    importedCount = updateIds.count();
+  } else if (isInTransaction) {
+    db.rollback();
+    undoLog.rollBackTo(loggedCount);
   }
 
-  return id;
+  return isRunningOkay;
 }
 
-bool Data::getDataModified() const {
-  return dataModified;
-}
+QList<QPair<QString, qint64> > Data::payeeRules() const {
+  QList<QPair<QString, qint64> > rules;
 
-void Data::setDataModified(bool isDataModified) {
-  dataModified = isDataModified;
+  // the longest pattern is tried first, so "acme fuel" wins over "acme"
+  QSqlQuery query;
+  query.setForwardOnly(true);
+  query.exec(
+    "select\n"
+    "  pattern\n"
+    "  , itemId\n"
+    "from\n"
+    "  payeeRule\n"
+    "order by\n"
+    "  length(pattern) desc\n"
+    "  , pattern\n");
+
+  while (query.next()) {
+    rules << qMakePair(query.value(0).toString(), query.value(1).toLongLong());
+  }
+
+  return rules;
 }
 
-void Data::clonePeriodAs(QString sourcePeriodId, QString periodId) {
-  bool isRunningOkay = true;
+qint64 Data::matchPayeeRule(
+    const QList<QPair<QString, qint64> > &rules, QString payee) {
+  qint64 itemId = 0;
 
-	if (sourcePeriodId.isEmpty()
-			|| periodId.isEmpty()) {
-    isRunningOkay = false;
+  for (int rule = 0; itemId == 0 && rule < rules.count(); ++rule) {
+    if (payee.contains(rules.at(rule).first, Qt::CaseInsensitive)) {
+      itemId = rules.at(rule).second;
+    }
   }
 
-	// get the source register ids
-  QString registerSelectStatement =
-    "select distinct\n"
-		"  id\n"
-    "from\n"
-    "  register\n"
-    "where\n"
-    "  periodId = '%1'\n";
+  return itemId;
+}
 
-  QSqlQuery registerQuery(registerSelectStatement.arg(sourcePeriodId));
-  QStringList sourceRegisterIds;
+qint64 Data::maxRegisterId() const {
+  QSqlQuery query(
+    "select\n"
+    "  ifnull(max(id), 0)\n"
+    "from\n"
+    "  register\n");
 
-	while (registerQuery.next()) {
-    sourceRegisterIds += registerQuery.value(0).toString();
-  }
+  qint64 id = 0;
 
-  if (sourceRegisterIds.count() == 0) {
-    isRunningOkay = false;
+  if (query.next()) {
+    id = query.value(0).toLongLong();
   }
 
-  if (isRunningOkay) {
-    foreach(QString sourceRegisterId, sourceRegisterIds) {
-      // insert into the period all of the source registers and values
-			QString queryString =
-				"insert into register(\n"
-				"  id\n"
-				"  , periodId\n"
-				"  , itemId\n"
-				"  , budget\n"
-				"  , actual\n"
-				"  , note)\n"
-				"select\n"
-				"  '%1'\n"
-				"  , '%2'\n"
-				"  , rmv.itemId\n"
-				"  , rmv.budget\n"
-				"  , rmv.actual\n"
-				"  , rmv.note\n"
-				"from\n"
-				"  registerMetricsView rmv\n"
-				"where\n"
-				"  registerId = '%3'\n";
-
-			queryString =
-				queryString
-					.arg(getNewPrimaryKeyId())
-					.arg(periodId)
-					.arg(sourceRegisterId);
-
-			QSqlQuery query(queryString);
-
-      if (!query.exec()) {
-        isRunningOkay = false;
-      }
-    }
-  }
+  return id;
 }
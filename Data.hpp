@@ -27,24 +27,44 @@
   #define _CASHFLOW_DATA_HPP_
   
   #include <QFile>
-  #include <QProgressDialog>
+  #include <QMap>
   #include <QString>
+  #include <QStringList>
   #include <QTemporaryFile>
   #include <QScopedPointer>
   #include <QSqlDatabase>
+  #include <QSqlQuery>
+
+  #include "MetricsCache.hpp"
+  #include "SaveWorker.hpp"
+  #include "StatementReader.hpp"
+  #include "UndoLog.hpp"
 
   namespace Cashflow {
     class Data : public QObject {
     public:
       Data();
+      ~Data();
   
       bool newDatabase();
       bool connectToDatabase(QString fileName = QString());
-      bool save();
-      bool saveAs();
-      bool backupAs();
-      bool undo(quint16 index) const;
-      bool redo(quint16 index) const;
+      bool openReadOnly(QString fileName = QString());
+      bool isReadOnly() const;
+      QStringList leftoverWorkingFiles() const;
+      bool recoverWorkingFile(QString fileName);
+      void discardWorkingFile(QString fileName);
+      bool save(qint64 logUndoRedoIndex);
+      bool saveAs(qint64 logUndoRedoIndex);
+      bool backupAs(qint64 logUndoRedoIndex);
+      bool autosave(qint64 logUndoRedoIndex);
+      bool finishSave();
+      bool isSaving() const;
+      bool undo(qint64 firstIndex, qint64 lastIndex);
+      bool redo(qint64 firstIndex, qint64 lastIndex);
+      qint64 undoGroupStart(qint64 lastIndex) const;
+      qint64 redoGroupEnd(qint64 firstIndex) const;
+      bool beginUndoGroup();
+      bool endUndoGroup();
       bool categoryHasItems(QString categoryId);
       bool itemInRegister(QString itemId);
 
@@ -66,19 +86,52 @@
 
       QString getNewPrimaryKeyId() const;
 
-      quint16 logUndoRedoCount() const;
-			quint16 nThLogUndoRedoId(quint16 index) const;
+      qint64 logUndoRedoCount();
+			qint64 nThLogUndoRedoId(qint64 index) const;
 
-      bool deleteFromLogUndoRedo(quint16 firstIndex, quint16 endIndex);
+      bool deleteFromLogUndoRedo(qint64 firstIndex, qint64 endIndex);
+      bool coalesceLogUndoRedo(qint64 index, int windowMilliseconds);
+      qint64 compactLogUndoRedo(
+        qint64 lastIndex, int horizonDays, int maxEntries);
+      void setUndoCachedRecordCount(int cachedRecordCount);
 
       bool getDataModified() const;
       void setDataModified(bool isDataModified);
 
-      void clonePeriodAs(QString sourcePeriodId, QString periodId);
+      bool clonePeriodAs(QString sourcePeriodId, QString periodId);
+      bool generatePeriods(
+        QString sourcePeriodId
+        , QStringList periodNames
+        , bool copyBudgets
+        , bool zeroActuals
+        , bool clearNotes);
+      bool registerAllItems(QString periodId);
+      QStringList changedRegisterItemNames(
+        QString periodId, int &registerCount) const;
+      bool unregisterAllItems(QString periodId, bool includeChanged);
+      QStringList unmatchedPayees(QStringList payees) const;
+      bool addPayeeRules(QMap<QString, QString> itemIdsByPattern);
+      bool importStatement(
+        const QList<StatementReader::Total> &totals
+        , int &importedCount
+        , QStringList &missingPeriodNames);
+
+      MetricsCache *getMetricsCache();
+      bool reloadMetricsCache();
+
+      SaveWorker *getSaveWorker();
+
+      void setPerformanceProfile(int pageSize, int cacheSizeKiB, qint64 mmapSize);
+      int getPageSize() const;
+      int getCacheSizeKiB() const;
+      qint64 getMmapSize() const;
 
     private:
       bool createNewDatabaseFile();
-      void createDatabaseStructure();
+      void createWorkingFile();
+      void applyConnectionProfile(bool isNewFile);
+      bool buildDatabase();
+      bool createDatabaseStructure();
 
       bool dropPeriodTable();
       bool createPeriodTable();
@@ -98,18 +151,75 @@
       bool createLogUndoRedoTable();
       bool dropLogUndoRedoTable();
 
+      bool createPayeeRuleTable();
+      bool dropPayeeRuleTable();
+
+      bool createIndexes();
+
+      bool dropRollupTables();
+      bool createRollupTables();
+      bool dropRollupTriggers();
+      bool createRollupTriggers();
+      bool fillRollupTables();
+
+      bool createMapViewTriggers();
+      bool createPeriodMetricsView();
+      bool createFlowMetricsView();
+      bool createCategoryMetricsView();
+      bool createRegisterMetricsView();
+
+      bool executeStatements(const QStringList &statements, QString message);
+
+      int databaseVersion() const;
+      bool setDatabaseVersion(int version);
+      bool upgradeDatabaseStructure();
+      bool convertAmountsToCents();
+      bool convertKeysToIntegers();
+      bool convertUndoLogToRecords();
+      bool addUndoLogTimes();
+
+      void loadLastPrimaryKeyId();
+      qint64 maxRegisterId() const;
+      bool insertRegisterRows(QString insertStatement, QString message);
+      QList<QPair<QString, qint64> > payeeRules() const;
+      static qint64 matchPayeeRule(
+        const QList<QPair<QString, qint64> > &rules, QString payee);
+
+      bool logRegisterRows(UndoLog::Operation operation, QString condition);
+
       void prepopulatePermanentData();
       void prepopulateMappableData();
       bool clearEditableData();
 
-      void prepopulateFlowTable(QProgressDialog &, int);
-      void prepopulateCategoryTable(QProgressDialog &, int);
-      void prepopulateItemTable(QProgressDialog &, int);
+      void prepopulateFlowTable();
+      void prepopulateCategoryTable();
+      void prepopulateItemTable();
       void insertItem(
-        QString flowName, QString categoryName, QString itemName);
+        QSqlQuery &query
+        , QString flowName
+        , QString categoryName
+        , QString itemName);
+
+      bool startSave(
+        QString saveFileName
+        , SaveWorker::Purpose purpose
+        , qint64 logUndoRedoIndex);
+      QString promptForSaveFileName(QString caption);
+      QString promptForOpenFileName(QString caption);
+      QString autosaveFileName() const;
+      void removeAutosaveFile();
 
-      bool saveFile(QString);
       bool openFile(QString);
+      bool openDatabaseCopy(QString fileName);
+      bool openInPlace(QString fileName);
+      void closeReadOnlyFile();
+      bool loadFlowIds();
+      bool copyOverWorkingFile(QString fileName);
+#ifdef CASHFLOW_SQLITE_BACKUP
+      bool backupIntoWorkingFile(QString fileName);
+      void startWorkingCopy(QString fileName);
+      bool openWorkingCopy();
+#endif
       
       QString uniqueSuffix();
       
@@ -120,6 +230,21 @@
       QString outFlowId;
       
       bool dataModified;
+
+      mutable qint64 lastPrimaryKeyId;
+
+      int pageSize;
+      int cacheSizeKiB;
+      qint64 mmapSize;
+
+      MetricsCache metricsCache;
+
+      UndoLog undoLog;
+
+      SaveWorker saveWorker;
+      bool savePending;
+
+      bool readOnly;
     };
   }
 #endif // _CASHFLOW_DATA_HPP_
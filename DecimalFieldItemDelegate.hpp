@@ -14,11 +14,13 @@
 //
 //  DecimalFieldItemDelegate class definition
 //    This class modifies to the QStyledItemDelegate class to help with
-//    displaying the currency amount fields to two decimal places.
+//    displaying and editing the currency amount fields, which are stored as
+//    whole cents, to two decimal places.
 
 #ifndef _DECIMALFIELDITEMDELEGATE_HPP_
   #define _DECIMALFIELDITEMDELEGATE_HPP_
 
+  #include <QDoubleSpinBox>
   #include <QStyledItemDelegate>
 
   namespace Cashflow {
@@ -27,10 +29,51 @@
       DecimalFieldItemDelegate(QObject *parent = 0)
         : QStyledItemDelegate(parent) {}
 
-      QString displayText(const QVariant &value, const QLocale &) const {
-        QString str = QString::number(value.toDouble(), 'f', 2);
+      // format the cents with integer math so no rounding is involved
+      static QString centsToText(qint64 cents) {
+        qint64 magnitude = (cents < 0 ? -cents : cents);
+
+        QString str =
+          QString("%1%2.%3")
+            .arg(cents < 0 ? "-" : "")
+            .arg(magnitude / 100)
+            .arg(magnitude % 100, 2, 10, QChar('0'));
         return str;
       }
+
+      QString displayText(const QVariant &value, const QLocale &) const {
+        return centsToText(value.toLongLong());
+      }
+
+      QWidget *createEditor(
+        QWidget *parent
+        , const QStyleOptionViewItem &
+        , const QModelIndex &) const
+      {
+        QDoubleSpinBox *editor = new QDoubleSpinBox(parent);
+        editor->setFrame(false);
+        editor->setDecimals(2);
+        editor->setRange(-999999999.99, 999999999.99);
+        return editor;
+      }
+
+      void setEditorData(QWidget *editor, const QModelIndex &index) const {
+        QDoubleSpinBox *spinBox = static_cast<QDoubleSpinBox *>(editor);
+        spinBox->setValue(index.data(Qt::EditRole).toLongLong() / 100.0);
+      }
+
+      void setModelData(
+        QWidget *editor
+        , QAbstractItemModel *model
+        , const QModelIndex &index) const
+      {
+        QDoubleSpinBox *spinBox = static_cast<QDoubleSpinBox *>(editor);
+        spinBox->interpretText();
+        model->setData(
+          index
+          , qRound64(spinBox->value() * 100.0)
+          , Qt::EditRole);
+      }
     };
   }
 
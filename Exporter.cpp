@@ -0,0 +1,296 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  Exporter class source
+//    The class that writes the register or the period balances out to a CSV
+//    or JSON file a row at a time.
+//
+//  the query runs forward only and each row goes straight into the text
+//  stream's buffer, so the memory used stays the same however long the
+//  history in the file is
+
+#include <QtCore>
+#include <QtSql>
+
+#include "DecimalFieldItemDelegate.hpp"
+#include "Exporter.hpp"
+
+using Cashflow::DecimalFieldItemDelegate;
+using Cashflow::Exporter;
+
+// file name suffix that asks for JSON in place of CSV
+static const QString jsonFileSuffix = ".json";
+
+// columns held as integer cents, written out as decimal amounts
+static const char *centsColumnNames[] = {
+  "budget"
+  , "actual"
+  , "difference"
+  , "budgetBalance"
+  , "actualBalance"
+  , "differenceBalance"
+  , 0
+};
+
+static bool isCentsColumn(QString columnName) {
+  bool isCents = false;
+
+  for (int column = 0; !isCents && centsColumnNames[column]; ++column) {
+    isCents = (columnName == centsColumnNames[column]);
+  }
+
+  return isCents;
+}
+
+// the time-ordered ids run past the 2^53 that JSON readers keep exactly in a
+// double, so they are written as strings
+static bool isIdColumn(QString columnName) {
+  return columnName == "id" || columnName.endsWith("Id");
+}
+
+static bool isNumber(const QVariant &value) {
+  return
+    value.type() == QVariant::Int
+    || value.type() == QVariant::LongLong
+    || value.type() == QVariant::Double;
+}
+
+// quotes a CSV field only when it holds a delimiter, quote or line break
+static QString csvField(QString text) {
+  if (text.contains(',')
+      || text.contains('"')
+      || text.contains('\n')
+      || text.contains('\r')) {
+    text = "\"" + text.replace("\"", "\"\"") + "\"";
+  }
+
+  return text;
+}
+
+static QString jsonString(QString text) {
+  QString escaped = "\"";
+
+  for (int position = 0; position < text.length(); ++position) {
+    QChar character = text.at(position);
+
+    if (character == '"') {
+      escaped += "\\\"";
+    } else if (character == '\\') {
+      escaped += "\\\\";
+    } else if (character == '\n') {
+      escaped += "\\n";
+    } else if (character == '\r') {
+      escaped += "\\r";
+    } else if (character == '\t') {
+      escaped += "\\t";
+    } else if (character.unicode() < 0x20) {
+      escaped += QString("\\u%1").arg(character.unicode(), 4, 16, QChar('0'));
+    } else {
+      escaped += character;
+    }
+  }
+
+  return escaped + "\"";
+}
+
+bool Exporter::sourceFromName(QString name, Source &source) {
+  bool isRunningOkay = true;
+
+  name = name.toLower();
+
+  if (name == "register") {
+    source = RegisterSource;
+  } else if (name == "periods") {
+    source = PeriodSource;
+  } else {
+    isRunningOkay = false;
+  }
+
+  return isRunningOkay;
+}
+
+bool Exporter::isJsonFileName(QString fileName) {
+  return fileName.endsWith(jsonFileSuffix, Qt::CaseInsensitive);
+}
+
+Exporter::Exporter()
+    : rows(0) {
+  // intentionally empty function
+}
+
+bool Exporter::write(Source source, QString fileName) {
+  bool isRunningOkay = true;
+
+  rows = 0;
+  exportErrorText = "";
+
+  QFile file(fileName);
+
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    exportErrorText = file.errorString();
+
+    isRunningOkay = false;
+  }
+
+  QSqlQuery query;
+  query.setForwardOnly(true);
+
+  if (isRunningOkay) {
+    if (source == RegisterSource) {
+      query.exec(
+        "select\n"
+        "  registerId\n"
+        "  , periodId\n"
+        "  , itemId\n"
+        "  , periodName\n"
+        "  , flowName\n"
+        "  , categoryName\n"
+        "  , itemName\n"
+        "  , note\n"
+        "  , budget\n"
+        "  , actual\n"
+        "  , difference\n"
+        "from\n"
+        "  registerMetricsView\n"
+        "order by\n"
+        "  periodId\n"
+        "  , registerId\n");
+    } else {
+      query.exec(
+        "select\n"
+        "  periodId\n"
+        "  , periodName\n"
+        "  , budgetBalance\n"
+        "  , actualBalance\n"
+        "  , differenceBalance\n"
+        "from\n"
+        "  periodMetricsView\n"
+        "order by\n"
+        "  periodId\n");
+    }
+
+    if (!query.isActive()) {
+      exportErrorText = query.lastError().text();
+
+      isRunningOkay = false;
+    }
+  }
+
+  if (isRunningOkay) {
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+
+    if (isJsonFileName(fileName)) {
+      writeJson(query, out);
+    } else {
+      writeCsv(query, out);
+    }
+
+    out.flush();
+
+    if (out.status() != QTextStream::Ok
+        || file.error() != QFile::NoError) {
+      exportErrorText = file.errorString();
+
+      isRunningOkay = false;
+    }
+  }
+
+  return isRunningOkay;
+}
+
+int Exporter::rowCount() const {
+  return rows;
+}
+
+QString Exporter::errorText() const {
+  return exportErrorText;
+}
+
+void Exporter::writeCsv(QSqlQuery &query, QTextStream &out) {
+  QSqlRecord record = query.record();
+
+  QVector<bool> isCents(record.count());
+
+  for (int column = 0; column < record.count(); ++column) {
+    isCents[column] = isCentsColumn(record.fieldName(column));
+
+    out << (column > 0 ? "," : "") << record.fieldName(column);
+  }
+
+  out << "\n";
+
+  while (query.next()) {
+    for (int column = 0; column < record.count(); ++column) {
+      QVariant value = query.value(column);
+
+      if (column > 0) {
+        out << ",";
+      }
+
+      if (isCents[column]) {
+        out << DecimalFieldItemDelegate::centsToText(value.toLongLong());
+      } else if (!value.isNull()) {
+        out << csvField(value.toString());
+      }
+    }
+
+    out << "\n";
+
+    ++rows;
+  }
+}
+
+// writes an array with one object per row, a row to a line
+void Exporter::writeJson(QSqlQuery &query, QTextStream &out) {
+  QSqlRecord record = query.record();
+
+  QVector<bool> isCents(record.count());
+  QVector<bool> isId(record.count());
+  QStringList names;
+
+  for (int column = 0; column < record.count(); ++column) {
+    isCents[column] = isCentsColumn(record.fieldName(column));
+    isId[column] = isIdColumn(record.fieldName(column));
+    names << jsonString(record.fieldName(column)) + ": ";
+  }
+
+  out << "[";
+
+  while (query.next()) {
+    out << (rows > 0 ? ",\n  {" : "\n  {");
+
+    for (int column = 0; column < record.count(); ++column) {
+      QVariant value = query.value(column);
+
+      out << (column > 0 ? ", " : "") << names.at(column);
+
+      if (value.isNull()) {
+        out << "null";
+      } else if (isCents[column]) {
+        out << DecimalFieldItemDelegate::centsToText(value.toLongLong());
+      } else if (isNumber(value) && !isId[column]) {
+        out << value.toString();
+      } else {
+        out << jsonString(value.toString());
+      }
+    }
+
+    out << "}";
+
+    ++rows;
+  }
+
+  out << "\n]\n";
+}
@@ -0,0 +1,53 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  Exporter class definition
+//    The class that writes the register or the period balances out to a CSV
+//    or JSON file a row at a time.
+
+#ifndef _CASHFLOW_EXPORTER_HPP_
+  #define _CASHFLOW_EXPORTER_HPP_
+
+  #include <QString>
+
+  class QSqlQuery;
+  class QTextStream;
+
+  namespace Cashflow {
+    class Exporter {
+    public:
+      enum Source {
+        RegisterSource
+        , PeriodSource
+      };
+
+      static bool sourceFromName(QString name, Source &source);
+      static bool isJsonFileName(QString fileName);
+
+      Exporter();
+
+      bool write(Source source, QString fileName);
+
+      int rowCount() const;
+      QString errorText() const;
+
+    private:
+      void writeCsv(QSqlQuery &query, QTextStream &out);
+      void writeJson(QSqlQuery &query, QTextStream &out);
+
+      int rows;
+      QString exportErrorText;
+    };
+  }
+#endif // _CASHFLOW_EXPORTER_HPP_
@@ -0,0 +1,95 @@
+//  Copyright 2014 Jason Eric Timms
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  GeneratePeriodsForm class source
+//    The class that asks how many periods to generate from a source period
+//    and which of its register values to carry into them.
+
+#include <QtGui>
+
+#include "GeneratePeriodsForm.hpp"
+
+using Cashflow::GeneratePeriodsForm;
+
+// generated periods are named by month in English, like "January 2015", so
+// that statements and reports find them whatever the system locale
+static const QString periodNameFormat = "MMMM yyyy";
+
+GeneratePeriodsForm::GeneratePeriodsForm(
+    QString sourcePeriodName, QWidget *parent) : QDialog(parent) {
+
+  periodCountSpinBox = new QSpinBox(this);
+  periodCountSpinBox->setRange(1, 120);
+  periodCountSpinBox->setValue(12);
+
+  QDate nextMonth = QDate::currentDate().addMonths(1);
+
+  firstPeriodDateEdit = new QDateEdit(this);
+  firstPeriodDateEdit->setDisplayFormat(periodNameFormat);
+  firstPeriodDateEdit->setDate(QDate(nextMonth.year(), nextMonth.month(), 1));
+
+  copyBudgetsCheckBox = new QCheckBox(tr("Copy &budgets"), this);
+  copyBudgetsCheckBox->setChecked(true);
+
+  zeroActualsCheckBox = new QCheckBox(tr("&Zero actuals"), this);
+  zeroActualsCheckBox->setChecked(true);
+
+  clearNotesCheckBox = new QCheckBox(tr("Clear &notes"), this);
+  clearNotesCheckBox->setChecked(true);
+
+  QFormLayout *periodLayout = new QFormLayout;
+  periodLayout->addRow(tr("&Periods:"), periodCountSpinBox);
+  periodLayout->addRow(tr("&First period:"), firstPeriodDateEdit);
+  periodLayout->addRow(copyBudgetsCheckBox);
+  periodLayout->addRow(zeroActualsCheckBox);
+  periodLayout->addRow(clearNotesCheckBox);
+
+  buttonBox =
+    new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+
+  connect(buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
+  connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+
+  QVBoxLayout *mainLayout = new QVBoxLayout;
+  mainLayout->addLayout(periodLayout);
+  mainLayout->addWidget(buttonBox);
+  setLayout(mainLayout);
+
+  setWindowTitle(tr("Generate Periods from %1").arg(sourcePeriodName));
+}
+
+QStringList GeneratePeriodsForm::periodNames() const {
+  QStringList names;
+
+  QDate firstPeriod = firstPeriodDateEdit->date();
+
+  for (int period = 0; period < periodCountSpinBox->value(); ++period) {
+    names <<
+      QLocale::c().toString(firstPeriod.addMonths(period), periodNameFormat);
+  }
+
+  return names;
+}
+
+bool GeneratePeriodsForm::copyBudgets() const {
+  return copyBudgetsCheckBox->isChecked();
+}
+
+bool GeneratePeriodsForm::zeroActuals() const {
+  return zeroActualsCheckBox->isChecked();
+}
+
+bool GeneratePeriodsForm::clearNotes() const {
+  return clearNotesCheckBox->isChecked();
+}
@@ -0,0 +1,51 @@
+//  Copyright 2014 Jason Eric Timms
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  GeneratePeriodsForm class definition
+//    The class that asks how many periods to generate from a source period
+//    and which of its register values to carry into them.
+
+#ifndef _GENERATEPERIODSFORM_HPP_
+  #define _GENERATEPERIODSFORM_HPP_
+
+  #include <QDialog>
+  #include <QStringList>
+
+  class QCheckBox;
+  class QDateEdit;
+  class QDialogButtonBox;
+  class QSpinBox;
+
+  namespace Cashflow {
+    class GeneratePeriodsForm : public QDialog {
+      Q_OBJECT
+  
+    public:
+      GeneratePeriodsForm(QString sourcePeriodName, QWidget *parent = (QWidget *)0);
+
+      QStringList periodNames() const;
+      bool copyBudgets() const;
+      bool zeroActuals() const;
+      bool clearNotes() const;
+    
+    private:
+      QSpinBox *periodCountSpinBox;
+      QDateEdit *firstPeriodDateEdit;
+      QCheckBox *copyBudgetsCheckBox;
+      QCheckBox *zeroActualsCheckBox;
+      QCheckBox *clearNotesCheckBox;
+      QDialogButtonBox *buttonBox;
+    };
+  }
+#endif //_GENERATEPERIODSFORM_HPP_
@@ -23,31 +23,50 @@
 #include "MainForm.hpp"
 
 #include "Application.hpp"
+#include "ConsolidatedReport.hpp"
+#include "ConsolidatedReportForm.hpp"
 #include "DecimalFieldItemDelegate.hpp"
+#include "GeneratePeriodsForm.hpp"
 #include "HeaderView.hpp"
 #include "ManageCategoriesForm.hpp"
 #include "ManageItemsForm.hpp"
+#include "MetricsModel.hpp"
+#include "PayeeRulesForm.hpp"
+#include "SaveWorker.hpp"
+#include "StatementReader.hpp"
 #include "SqlTableModel.hpp"
 #include "TableView.hpp"
 
 using Cashflow::Application;
+using Cashflow::ConsolidatedReport;
+using Cashflow::ConsolidatedReportForm;
 using Cashflow::Data;
 using Cashflow::DecimalFieldItemDelegate;
+using Cashflow::Exporter;
 using Cashflow::HeaderView;
 using Cashflow::MainForm;
 using Cashflow::ManageCategoriesForm;
 using Cashflow::ManageItemsForm;
+using Cashflow::PayeeRulesForm;
+using Cashflow::SaveWorker;
 using Cashflow::SqlTableModel;
+using Cashflow::StatementReader;
 using Cashflow::TableView;
 
 static const QString applicationTitle = "Cashflow";
 static const QString modifiedFileIndicator = "[*]";
 static const QString titleFileSeperator = " - ";
+static const QString readOnlyFileIndicator = " (read-only)";
+
+// the primary keys are integers, so filter on them as numbers
+static QString keyFilter(QString fieldName, QString id) {
+  return QString("%1 = %2").arg(fieldName).arg(id.toLongLong());
+}
 
 MainForm::MainForm()
   : periodModel((SqlTableModel *)0)
-  , flowModel((SqlTableModel *)0)
-  , categoryModel((SqlTableModel *)0)
+  , flowModel((MetricsModel *)0)
+  , categoryModel((MetricsModel *)0)
   , registerModel((SqlTableModel *)0)
   , unusedModel((SqlTableModel *)0)
   , periodView((TableView *)0)
@@ -82,6 +101,27 @@ MainForm::MainForm()
   createActions();
   setupEmpty();
 
+  // saves run on their own thread, with a busy bar in the status bar
+  saveProgressBar = new QProgressBar(this);
+  saveProgressBar->setRange(0, 0);
+  saveProgressBar->setMaximumWidth(INITIAL_WIDTH_BLANK);
+  saveProgressBar->setVisible(false);
+  statusBar()->addPermanentWidget(saveProgressBar);
+
+  connect(
+    qApp->getSaveWorker()
+    , SIGNAL(finished())
+    , this
+    , SLOT(saveFinished()));
+
+  autosaveTimer = new QTimer(this);
+
+  connect(
+    autosaveTimer
+    , SIGNAL(timeout())
+    , this
+    , SLOT(autosave()));
+
   // if opened file, load recent list
   if (!qApp->savedDatabaseName().isEmpty()) {
     addCurrentFileToRecentList();
@@ -131,6 +171,15 @@ void MainForm::setup() {
   createPanels();
   dockSummaryPanels();
 
+  // a file opened read-only keeps every action that writes turned off, and
+  // its grids take no edits
+  setEditingEnabled(!qApp->isReadOnly());
+
+  if (qApp->isReadOnly()) {
+    periodView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    registerView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  }
+
   splitter = new QSplitter(Qt::Vertical);
   splitter->setFrameStyle(QFrame::StyledPanel);
   splitter->addWidget(registerPanel);
@@ -144,6 +193,11 @@ void MainForm::setup() {
   setCentralWidget(mainGroupBox);
 
   // set up connections for updating the views on a data change
+  //   period names and periods feed the metrics cache, so reload it first
+  connect(
+    periodModel, SIGNAL(dataSubmitted())
+    , this, SLOT(reloadMetricsCache()));
+
   connect(
     periodModel, SIGNAL(dataSubmitted())
     , this, SLOT(updateViewsAfterChange()));
@@ -223,7 +277,8 @@ void MainForm::displayDefaultTitle() {
   setWindowTitle(QObject::tr(
     applicationTitle.toUtf8()
     + titleFileSeperator.toUtf8()
-    + qApp->savedDatabaseName().toUtf8()));
+    + qApp->savedDatabaseName().toUtf8()
+    + (qApp->isReadOnly() ? readOnlyFileIndicator.toUtf8() : QByteArray())));
 
   setWindowModified(false);
 }
@@ -331,6 +386,9 @@ void MainForm::clearModelFilters() {
   categoryModelFilter = "";
   registerModelFilter = "";
 
+  periodModelFilterId = "";
+  flowModelFilterId = "";
+
   periodModelFilterLabel = "";
   flowModelFilterLabel = "";
   categoryModelFilterLabel = "";
@@ -357,6 +415,15 @@ void MainForm::createFileActions() {
   openAction->setStatusTip(tr("Open an existing cashflow file"));
   connect(openAction, SIGNAL(triggered()), this, SLOT(open()));
 
+  openReadOnlyAction = new QAction(tr("Open Read-&Only..."), this);
+  openReadOnlyAction->setStatusTip(
+    tr("Look through a saved cashflow file in place without changing it"));
+  connect(
+    openReadOnlyAction
+    , SIGNAL(triggered())
+    , this
+    , SLOT(openReadOnly()));
+
   revertAction = new QAction(tr("&Revert"), this);
   revertAction->setIcon(QIcon(imagePathSmashing_gemicons + "/row 10/14.png"));
   revertAction->setStatusTip(tr("Revert to the last save of the current cashflow file"));
@@ -407,6 +474,43 @@ void MainForm::createFileActions() {
     , this
     , SLOT(manageItems()));
 
+  importStatementAction = new QAction(tr("Import &Statement..."), this);
+  importStatementAction->setStatusTip(
+    tr("Add the transactions of a CSV or OFX bank statement to the actuals"));
+  connect(
+    importStatementAction
+    , SIGNAL(triggered())
+    , this
+    , SLOT(importStatement()));
+
+  exportRegisterAction = new QAction(tr("&Export Register..."), this);
+  exportRegisterAction->setStatusTip(
+    tr("Write every register entry to a CSV or JSON file"));
+  connect(
+    exportRegisterAction
+    , SIGNAL(triggered())
+    , this
+    , SLOT(exportRegister()));
+
+  exportPeriodsAction = new QAction(tr("Export &Periods..."), this);
+  exportPeriodsAction->setStatusTip(
+    tr("Write the balances of every period to a CSV or JSON file"));
+  connect(
+    exportPeriodsAction
+    , SIGNAL(triggered())
+    , this
+    , SLOT(exportPeriods()));
+
+  consolidatedReportAction =
+    new QAction(tr("Consolidated Re&port..."), this);
+  consolidatedReportAction->setStatusTip(
+    tr("Total the periods, flows and categories of several cashflow files"));
+  connect(
+    consolidatedReportAction
+    , SIGNAL(triggered())
+    , this
+    , SLOT(consolidatedReport()));
+
   propertiesAction = new QAction(tr("P&roperties..."), this);
   propertiesAction->setIcon(QIcon(imagePathSmashing_gemicons + "/row 4/2.png"));
   propertiesAction->setStatusTip(tr("Give some info on the current file"));
@@ -475,6 +579,15 @@ void MainForm::createEditActions() {
     , this
     , SLOT(clonePeriod()));
 
+  generatePeriodsAction = new QAction(tr("&Generate Periods..."), this);
+  generatePeriodsAction->setStatusTip(
+    tr("Generate a run of periods from the current period"));
+  connect(
+    generatePeriodsAction
+    , SIGNAL(triggered())
+    , this
+    , SLOT(generatePeriods()));
+
   deletePeriodAction = new QAction(tr("&Delete Period"), this);
   deletePeriodAction->setIcon(QIcon(imagePathSmashing_gemicons + "/row 8/12.png"));
   deletePeriodAction->setShortcut(tr("Ctrl+D"));
@@ -595,10 +708,14 @@ void MainForm::createMenus() {
   propertiesAction->setEnabled(true);
   manageCategoriesAction->setEnabled(true);
   manageItemsAction->setEnabled(true);
+  importStatementAction->setEnabled(true);
+  exportRegisterAction->setEnabled(true);
+  exportPeriodsAction->setEnabled(true);
 
   fileMenu = menuBar()->addMenu(tr("&File"));
   fileMenu->addAction(newAction);
   fileMenu->addAction(openAction);
+  fileMenu->addAction(openReadOnlyAction);
   fileMenu->addAction(revertAction);
   fileMenu->addAction(closeAction);
   fileMenu->addSeparator();
@@ -610,6 +727,10 @@ void MainForm::createMenus() {
   fileMenu->addSeparator();
   fileMenu->addAction(manageCategoriesAction);
   fileMenu->addAction(manageItemsAction);
+  fileMenu->addAction(importStatementAction);
+  fileMenu->addAction(exportRegisterAction);
+  fileMenu->addAction(exportPeriodsAction);
+  fileMenu->addAction(consolidatedReportAction);
 
   // add a seperator and save the pointer to hide it if no recently opened files
   seperatorAction = fileMenu->addSeparator();
@@ -629,6 +750,7 @@ void MainForm::createMenus() {
   editMenu->addSeparator();
   editMenu->addAction(addPeriodAction);
   editMenu->addAction(clonePeriodAction);
+  editMenu->addAction(generatePeriodsAction);
   editMenu->addAction(deletePeriodAction);
   editMenu->addSeparator();
   editMenu->addAction(registerItemAction);
@@ -660,10 +782,14 @@ void MainForm::createEmptyMenus() {
   manageItemsAction->setEnabled(false);
   manageItemsAction->setEnabled(false);
   manageItemsAction->setEnabled(false);
+  importStatementAction->setEnabled(false);
+  exportRegisterAction->setEnabled(false);
+  exportPeriodsAction->setEnabled(false);
 
   fileMenu = menuBar()->addMenu(tr("&File"));
   fileMenu->addAction(newAction);
   fileMenu->addAction(openAction);
+  fileMenu->addAction(openReadOnlyAction);
   fileMenu->addAction(revertAction);
   fileMenu->addAction(closeAction);
   fileMenu->addSeparator();
@@ -675,6 +801,10 @@ void MainForm::createEmptyMenus() {
   fileMenu->addSeparator();
   fileMenu->addAction(manageCategoriesAction);
   fileMenu->addAction(manageItemsAction);
+  fileMenu->addAction(importStatementAction);
+  fileMenu->addAction(exportRegisterAction);
+  fileMenu->addAction(exportPeriodsAction);
+  fileMenu->addAction(consolidatedReportAction);
 
   // add a seperator and save the pointer to hide it if no recently opened files
   seperatorAction = fileMenu->addSeparator();
@@ -775,9 +905,97 @@ void MainForm::open(QString fileName) {
       periodView->setFocus();
       displayDefaultTitle();
 
+      // the file can be read while it is copied to edit, and editing comes
+      // on once the copy is done
       revertAction->setEnabled(true);
-      undoAction->setEnabled(!qApp->logUndoRedoIndexAtZero());
-      redoAction->setEnabled(!qApp->logUndoRedoIndexAtMax());
+      undoAction->setEnabled(
+        !qApp->isReadOnly() && !qApp->logUndoRedoIndexAtZero());
+      redoAction->setEnabled(
+        !qApp->isReadOnly() && !qApp->logUndoRedoIndexAtMax());
+
+      if (qApp->isSaving()) {
+        statusBar()->showMessage(tr("Copying to edit..."));
+        saveProgressBar->setVisible(true);
+      }
+    }
+  }
+}
+
+void MainForm::openReadOnly() {
+  if (okToContinue()) {
+    if (qApp->openReadOnly()) {
+      deleteFileFormObjects();
+      setup();
+      showFileToolBar();
+      updateViewsAfterChange();
+      periodView->setFocus();
+      displayDefaultTitle();
+
+      undoAction->setEnabled(false);
+      redoAction->setEnabled(false);
+    }
+  }
+}
+
+void MainForm::setEditingEnabled(bool isEnabled) {
+  QList<QAction *> editingActions;
+  editingActions
+    << revertAction
+    << saveAction
+    << saveAsAction
+    << backupAsAction
+    << manageCategoriesAction
+    << manageItemsAction
+    << importStatementAction
+    << addPeriodAction
+    << clonePeriodAction
+    << generatePeriodsAction
+    << deletePeriodAction
+    << registerItemAction
+    << registerAllItemsAction
+    << unregisterItemAction
+    << unregisterAllItemsAction;
+
+  foreach (QAction *action, editingActions) {
+    action->setEnabled(isEnabled);
+  }
+}
+
+void MainForm::offerRecovery() {
+  QStringList fileNames = qApp->leftoverWorkingFiles();
+
+  if (!fileNames.isEmpty()) {
+    // the newest file comes first, and older ones are offered next time
+    int r =
+      QMessageBox::warning(
+        this
+        , tr("Cashflow")
+        , tr(
+          "Cashflow did not close properly, and unsaved work from %1 "
+          "was found.\n"
+          "Do you want to recover it?")
+          .arg(QFileInfo(fileNames.first()).lastModified().toString())
+        , QMessageBox::Yes | QMessageBox::No | QMessageBox::Discard);
+
+    // the recovered file replaces whatever is open, so settle that first
+    if (r == QMessageBox::Yes && okToContinue()) {
+      if (qApp->recoverWorkingFile(fileNames.first())) {
+        deleteFileFormObjects();
+        setup();
+        showFileToolBar();
+        updateViewsAfterChange();
+        periodView->setFocus();
+        displayUnsavedTitle();
+
+        revertAction->setEnabled(false);
+        undoAction->setEnabled(!qApp->logUndoRedoIndexAtZero());
+        redoAction->setEnabled(!qApp->logUndoRedoIndexAtMax());
+      }
+    }
+    else if (r == QMessageBox::Discard) {
+      foreach (QString fileName, fileNames) {
+        qApp->discardWorkingFile(fileName);
+      }
     }
   }
 }
@@ -860,19 +1078,79 @@ void MainForm::deleteFileFormObjects() {
 }
 
 void MainForm::save() {
-  qApp->save();
-  addCurrentFileToRecentList();
-  displayDefaultTitle();
-
-  revertAction->setEnabled(true);
+  if (qApp->save()) {
+    showSaveStarted(tr("Saving..."));
+  }
 }
 
 void MainForm::saveAs() {
-  qApp->saveAs();
-  addCurrentFileToRecentList();
-  displayDefaultTitle();
+  if (qApp->saveAs()) {
+    showSaveStarted(tr("Saving..."));
+  }
+}
 
-  revertAction->setEnabled(true);
+void MainForm::autosave() {
+  // only unsaved changes are worth a copy, and a running save comes first
+  if (isWindowModified()
+      && !qApp->isSaving()
+      && qApp->autosave()) {
+    showSaveStarted(tr("Autosaving..."));
+  }
+}
+
+void MainForm::showSaveStarted(QString message) {
+  statusBar()->showMessage(message);
+  saveProgressBar->setVisible(true);
+
+  // the save drops history past the horizon, which may be all of it
+  undoAction->setEnabled(!qApp->logUndoRedoIndexAtZero());
+}
+
+void MainForm::saveFinished() {
+  bool isRunningOkay = true;
+
+  // a save already finished by a later one has nothing left to report
+  isRunningOkay = qApp->isSaving();
+
+  SaveWorker::Purpose purpose = qApp->getSaveWorker()->purpose();
+
+  if (isRunningOkay) {
+    saveProgressBar->setVisible(false);
+    statusBar()->clearMessage();
+
+    isRunningOkay = qApp->finishSave();
+  }
+
+  if (isRunningOkay && purpose == SaveWorker::SaveFile) {
+    addCurrentFileToRecentList();
+
+    revertAction->setEnabled(true);
+
+    // edits made while the save ran are still unsaved
+    if (qApp->logUndoRedoIndexAtSaved() == true) {
+      displayDefaultTitle();
+    } else {
+      displayUnsavedTitle();
+    }
+
+    statusBar()->showMessage(tr("Saved"), 2000);
+  } else if (isRunningOkay && purpose == SaveWorker::AutosaveFile) {
+    statusBar()->showMessage(tr("Autosaved"), 2000);
+  } else if (isRunningOkay && purpose == SaveWorker::WorkingCopy) {
+    // the views read the file in place until now, so build them again on
+    // the copy that takes the edits
+    deleteFileFormObjects();
+    setup();
+    showFileToolBar();
+    updateViewsAfterChange();
+    periodView->setFocus();
+    displayDefaultTitle();
+
+    undoAction->setEnabled(!qApp->logUndoRedoIndexAtZero());
+    redoAction->setEnabled(!qApp->logUndoRedoIndexAtMax());
+
+    statusBar()->showMessage(tr("Ready to edit"), 2000);
+  }
 }
 
 void MainForm::addCurrentFileToRecentList() {
@@ -882,7 +1160,9 @@ void MainForm::addCurrentFileToRecentList() {
 }
 
 void MainForm::backupAs() {
-  qApp->backupAs();
+  if (qApp->backupAs()) {
+    showSaveStarted(tr("Saving a copy..."));
+  }
 }
 
 void MainForm::properties() {
@@ -916,8 +1196,9 @@ bool MainForm::okToContinue() {
           "Do you want to save your changes?")
         , QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
 
-    if (r == QMessageBox::Yes) {
-      qApp->save();
+    // the window may be about to close, so wait for the save to finish
+    if (r == QMessageBox::Yes && qApp->save()) {
+      saveFinished();
     }
     else if (r == QMessageBox::Cancel) {
       returnValue = false;
@@ -962,6 +1243,7 @@ void MainForm::undo() {
   redoAction->setEnabled(!qApp->logUndoRedoIndexAtMax());
 
   if (isRunningOkay) {
+    reloadMetricsCache();
     updateViewsAfterChange();
 
     // if unmodified before, set the display to show changes have been made
@@ -982,6 +1264,7 @@ void MainForm::redo() {
   redoAction->setEnabled(!qApp->logUndoRedoIndexAtMax());
 
   if (isRunningOkay) {
+    reloadMetricsCache();
     updateViewsAfterChange();
 
     // if unmodified before, set the display to show changes have been made
@@ -1066,6 +1349,9 @@ void MainForm::clonePeriod() {
 
   QString periodId = "";
 
+  // the new period and its copied rows undo as one step
+  qApp->beginUndoGroup();
+
   if (isRunningOkay) {
     periodView->setCurrentIndex(periodNameIndex);
 
@@ -1111,10 +1397,21 @@ void MainForm::clonePeriod() {
     }
   }
 
+  bool isCloned = false;
+
   if (isRunningOkay) {
     // clone the data
-    qApp->clonePeriodAs(sourcePeriodId, periodId);
+    isCloned = qApp->clonePeriodAs(sourcePeriodId, periodId);
+  }
 
+  qApp->endUndoGroup();
+
+  if (isRunningOkay) {
+    if (isCloned) {
+      showChangedOccured();
+    }
+
+    reloadMetricsCache();
     updateViewsAfterChange();
 
     // setFocus back to the period view again
@@ -1122,6 +1419,51 @@ void MainForm::clonePeriod() {
   }
 }
 
+void MainForm::generatePeriods() {
+  bool isRunningOkay = true;
+
+  QModelIndex sourcePeriodViewCurrent = periodView->currentIndex();
+
+  if (!sourcePeriodViewCurrent.isValid()) {
+    QMessageBox::warning(
+      (QWidget *)0
+      , QObject::tr("Error: Row not valid.")
+      , QObject::tr("Select the period to generate the new periods from."));
+
+    isRunningOkay = false;
+  }
+
+  QSqlRecord sourcePeriodRecord =
+    periodModel->record(sourcePeriodViewCurrent.row());
+  QString sourcePeriodId = sourcePeriodRecord.value("periodId").toString();
+  QString sourcePeriodName = sourcePeriodRecord.value("periodName").toString();
+
+  if (isRunningOkay) {
+    GeneratePeriodsForm form(sourcePeriodName, this);
+
+    isRunningOkay = (form.exec() == QDialog::Accepted);
+
+    // all of the periods and their registers go in as one undo entry
+    if (isRunningOkay) {
+      isRunningOkay =
+        qApp->generatePeriods(
+          sourcePeriodId
+          , form.periodNames()
+          , form.copyBudgets()
+          , form.zeroActuals()
+          , form.clearNotes());
+    }
+  }
+
+  if (isRunningOkay) {
+    showChangedOccured();
+    reloadMetricsCache();
+    updateViewsAfterChange();
+
+    periodView->setFocus();
+  }
+}
+
 void MainForm::deletePeriod() {
   bool isRunningOkay = true;
 
@@ -1353,13 +1695,13 @@ void MainForm::unregisterItem(int itemRow) {
     QString periodName = periodRecord.value("periodName").toString();
 
     // show warning if record has been changed
-    double budget = registerRecord.value("budget").toDouble();
-    double actual = registerRecord.value("actual").toDouble();
+    qint64 budget = registerRecord.value("budget").toLongLong();
+    qint64 actual = registerRecord.value("actual").toLongLong();
     QString note = registerRecord.value("note").toString();
 
     if (
-      abs(budget) >= 0.01 
-      || abs(actual) >= 0.01
+      budget != 0
+      || actual != 0
       || note != "")
     {
       if (unregisterChangedChoice == QMessageBox::NoToAll) {
@@ -1419,12 +1761,14 @@ void MainForm::unregisterItem(int itemRow) {
 }
 
 void MainForm::manageCategories() {
-  int categoryId = -1;
+  QString categoryId = "";
 
   QModelIndex index = categoryView->currentIndex();
   if (index.isValid()) {
-    QSqlRecord record = categoryModel->record(index.row());
-    categoryId = record.value(CategoryMetricsView_CategoryId).toInt();
+    categoryId =
+      categoryModel->value(
+        index.row()
+        , CategoryMetricsView_CategoryId).toString();
   }
 
   ManageCategoriesForm form(categoryId, this);
@@ -1433,7 +1777,10 @@ void MainForm::manageCategories() {
     &form, SIGNAL(mappingChanged())
     , this, SLOT(setMappingChanged()));
 
+  // everything done in the dialog undoes as one step
+  qApp->beginUndoGroup();
   form.exec();
+  qApp->endUndoGroup();
 
   disconnect(
     &form, SIGNAL(mappingChanged())
@@ -1444,24 +1791,29 @@ void MainForm::manageCategories() {
     resetMappingChanged();
   }
 
+  reloadMetricsCache();
   updateViews();
 }
 
 void MainForm::manageItems() {
-  int itemId = -1;
+  // the dialog opens on the category of the current register row's item
+  QString categoryId = "";
   QModelIndex index = registerView->currentIndex();
   if (index.isValid()) {
     QSqlRecord record = registerModel->record(index.row());
-    itemId = record.value(RegisterMetricsView_ItemId).toInt();
+    categoryId = record.value(RegisterMetricsView_CategoryId).toString();
   }
 
-  ManageItemsForm form(itemId, this);
+  ManageItemsForm form(categoryId, this);
 
   connect(
     &form, SIGNAL(mappingChanged())
     , this, SLOT(setMappingChanged()));
 
+  // everything done in the dialog undoes as one step
+  qApp->beginUndoGroup();
   form.exec();
+  qApp->endUndoGroup();
 
   disconnect(
     &form, SIGNAL(mappingChanged())
@@ -1472,9 +1824,208 @@ void MainForm::manageItems() {
     resetMappingChanged();
   }
 
+  reloadMetricsCache();
   updateViews();
 }
 
+void MainForm::importStatement() {
+  bool isRunningOkay = true;
+
+  QString fileName =
+    QFileDialog::getOpenFileName(
+      this
+      , tr("Import Statement")
+      , "."
+      , tr("Bank statements (*.csv *.ofx *.qfx);;All files (*)"));
+
+  if (fileName.isEmpty()) {
+    isRunningOkay = false;
+  }
+
+  // the file is read once into totals by month and payee, which is all the
+  // rest of the import works from
+  StatementReader reader;
+
+  if (isRunningOkay) {
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    isRunningOkay = reader.read(fileName);
+    QApplication::restoreOverrideCursor();
+
+    if (!isRunningOkay) {
+      QMessageBox::warning(
+        this
+        , tr("Could not import the statement.")
+        , reader.errorText());
+    }
+  }
+
+  // payees without a rule are offered once; any left unassigned are skipped
+  if (isRunningOkay) {
+    QStringList unmatchedPayees = qApp->unmatchedPayees(reader.payees());
+
+    if (!unmatchedPayees.isEmpty()) {
+      PayeeRulesForm form(unmatchedPayees, this);
+
+      isRunningOkay =
+        form.exec() == QDialog::Accepted
+        && qApp->addPayeeRules(form.itemIdsByPattern());
+
+      // the rules are saved with the document even when nothing imports
+      if (isRunningOkay) {
+        qApp->setUnloggedChange();
+        displayUnsavedTitle();
+      }
+    }
+  }
+
+  int importedCount = 0;
+  QStringList missingPeriodNames;
+
+  if (isRunningOkay) {
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    isRunningOkay =
+      qApp->importStatement(
+        reader.totals()
+        , importedCount
+        , missingPeriodNames);
+    QApplication::restoreOverrideCursor();
+  }
+
+  // the import is one undo entry, so the views catch up with it once
+  if (isRunningOkay
+      && importedCount > 0) {
+    showChangedOccured();
+    reloadMetricsCache();
+    updateViewsAfterChange();
+  }
+
+  if (isRunningOkay) {
+    statusBar()->showMessage(
+      tr("Imported %1 transactions into %2 register entries")
+        .arg(reader.transactionCount())
+        .arg(importedCount)
+      , 5000);
+
+    if (!missingPeriodNames.isEmpty()
+        || reader.skippedLineCount() > 0) {
+      QString message;
+
+      if (!missingPeriodNames.isEmpty()) {
+        message +=
+          tr("These months have no period, so were left out:\n")
+          + missingPeriodNames.join("\n")
+          + "\n";
+      }
+
+      if (reader.skippedLineCount() > 0) {
+        message +=
+          tr("%1 lines could not be read as transactions.")
+            .arg(reader.skippedLineCount());
+      }
+
+      QMessageBox::information(
+        this
+        , tr("Import Statement")
+        , message.trimmed());
+    }
+  }
+}
+
+void MainForm::exportRegister() {
+  exportSource(Exporter::RegisterSource, tr("Export Register"));
+}
+
+void MainForm::exportPeriods() {
+  exportSource(Exporter::PeriodSource, tr("Export Periods"));
+}
+
+void MainForm::exportSource(Exporter::Source source, QString caption) {
+  bool isRunningOkay = true;
+
+  QString csvFilter = tr("CSV files (*.csv)");
+  QString jsonFilter = tr("JSON files (*.json)");
+  QString selectedFilter;
+
+  QString fileName =
+    QFileDialog::getSaveFileName(
+      this
+      , caption
+      , "."
+      , csvFilter + ";;" + jsonFilter
+      , &selectedFilter);
+
+  if (fileName.isEmpty()) {
+    isRunningOkay = false;
+  }
+
+  // the format follows the suffix, so give the name the one chosen
+  if (isRunningOkay
+      && QFileInfo(fileName).suffix().isEmpty()) {
+    fileName += (selectedFilter == jsonFilter ? ".json" : ".csv");
+  }
+
+  Exporter exporter;
+
+  if (isRunningOkay) {
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    isRunningOkay = exporter.write(source, fileName);
+    QApplication::restoreOverrideCursor();
+
+    if (!isRunningOkay) {
+      QMessageBox::warning(
+        this
+        , tr("Could not export.")
+        , exporter.errorText());
+    }
+  }
+
+  if (isRunningOkay) {
+    statusBar()->showMessage(
+      tr("Exported %1 rows").arg(exporter.rowCount())
+      , 5000);
+  }
+}
+
+void MainForm::consolidatedReport() {
+  bool isRunningOkay = true;
+
+  QStringList fileNames =
+    QFileDialog::getOpenFileNames(
+      this
+      , tr("Consolidated Report")
+      , "."
+      , tr(
+        "Cashflow files (*.db *.dat *.cashflow *.cashflowz);;"
+        "SQLite Database files (*.db *.dat *.cashflow);;"
+        "Compressed cashflow files (*.cashflowz)"));
+
+  if (fileNames.isEmpty()) {
+    isRunningOkay = false;
+  }
+
+  // the files are read from disk as saved, one thread to a file
+  ConsolidatedReport report;
+
+  if (isRunningOkay) {
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    report.run(fileNames);
+    QApplication::restoreOverrideCursor();
+
+    if (!report.errors().isEmpty()) {
+      QMessageBox::warning(
+        this
+        , tr("Some files were left out of the report.")
+        , report.errors().join("\n"));
+    }
+  }
+
+  if (isRunningOkay) {
+    ConsolidatedReportForm form(report, fileNames, this);
+
+    form.exec();
+  }
+}
+
 void MainForm::createPeriodPanel() {
   periodModel = new SqlTableModel(this);
   periodModel->setTable("periodMetricsView");
@@ -1532,8 +2083,11 @@ void MainForm::createPeriodPanel() {
 }
 
 void MainForm::createFlowPanel() {
-  flowModel = new SqlTableModel(this);
-  flowModel->setTable("flowMetricsView");
+  flowModel =
+    new MetricsModel(
+      qApp->getMetricsCache()
+      , MetricsModel::FlowLevel
+      , this);
   flowModel->setSort(FlowMetricsView_FlowName, Qt::AscendingOrder);
 
   flowModel->setHeaderData(
@@ -1546,7 +2100,6 @@ void MainForm::createFlowPanel() {
     FlowMetricsView_Actual, Qt::Horizontal, tr("Actual"));
   flowModel->setHeaderData(
     FlowMetricsView_Difference, Qt::Horizontal, tr("Difference"));
-  flowModel->setEditStrategy(QSqlTableModel::OnRowChange);
   flowModel->select();
 
   flowView = new TableView(this);
@@ -1582,8 +2135,11 @@ void MainForm::createFlowPanel() {
 }
 
 void MainForm::createCategoryPanel() {
-  categoryModel = new SqlTableModel(this);
-  categoryModel->setTable("categoryMetricsView");
+  categoryModel =
+    new MetricsModel(
+      qApp->getMetricsCache()
+      , MetricsModel::CategoryLevel
+      , this);
 
   categoryModel->setSort(CategoryMetricsView_CategoryName, Qt::AscendingOrder);
   categoryModel->setHeaderData(
@@ -1598,7 +2154,6 @@ void MainForm::createCategoryPanel() {
     CategoryMetricsView_Actual, Qt::Horizontal, tr("Actual"));
   categoryModel->setHeaderData(
     CategoryMetricsView_Difference, Qt::Horizontal, tr("Difference"));
-  categoryModel->setEditStrategy(QSqlTableModel::OnRowChange);
   categoryModel->select();
 
   categoryView = new TableView(this);
@@ -1665,6 +2220,34 @@ void MainForm::createRegisterPanel() {
     , this
     , SLOT(validateRegisterModelMetrics(int, QSqlRecord &)));
 
+  // keep the metrics cache in step with single register edits
+  //   connected after the validation so the corrected values are used
+  connect(
+    registerModel
+    , SIGNAL(beforeInsert(QSqlRecord &))
+    , this
+    , SLOT(updateMetricsCacheBeforeInsert(QSqlRecord &)));
+
+  connect(
+    registerModel
+    , SIGNAL(beforeUpdate(int, QSqlRecord &))
+    , this
+    , SLOT(updateMetricsCacheBeforeUpdate(int, QSqlRecord &)));
+
+  connect(
+    registerModel
+    , SIGNAL(beforeDelete(int))
+    , this
+    , SLOT(updateMetricsCacheBeforeDelete(int)));
+
+  // the before signals come ahead of the SQL, so a submit that fails leaves
+  // the cache ahead of the database until it is read again
+  connect(
+    registerModel
+    , SIGNAL(dataSubmitFailed())
+    , this
+    , SLOT(reloadMetricsCache()));
+
   registerView = new TableView(this);
   registerView->setModel(registerModel);
   registerView->setItemDelegate(new QSqlRelationalDelegate(this));
@@ -1754,11 +2337,13 @@ void MainForm::updatePeriodView() {
     QSqlRecord record = periodModel->record(index.row());
     QString periodId = record.value("periodId").toString();
 
-    periodModelFilter = QString("periodId = '%1'").arg(periodId);
+    periodModelFilter = keyFilter("periodId", periodId);
+    periodModelFilterId = periodId;
     periodModelFilterLabel =
       tr("Period %1").arg(record.value("PeriodName").toString());
 
     flowModelFilter = "";
+    flowModelFilterId = "";
     flowModelFilterLabel = "";
 
     categoryModelFilter = "";
@@ -1780,12 +2365,14 @@ void MainForm::updateFlowView() {
   QModelIndex index = flowView->currentIndex();
 
   if (index.isValid()) {
-    QSqlRecord record = flowModel->record(index.row());
-    QString flowId = record.value("flowId").toString();
+    QString flowId =
+      flowModel->value(index.row(), FlowMetricsView_FlowId).toString();
+    QString flowName =
+      flowModel->value(index.row(), FlowMetricsView_FlowName).toString();
 
-    flowModelFilter = QString("flowId = '%1'").arg(flowId);
-    flowModelFilterLabel =
-      tr("Flow %1").arg(record.value("FlowName").toString());
+    flowModelFilter = keyFilter("flowId", flowId);
+    flowModelFilterId = flowId;
+    flowModelFilterLabel = tr("Flow %1").arg(flowName);
 
     categoryModelFilter = "";
     categoryModelFilterLabel = "";
@@ -1804,12 +2391,17 @@ void MainForm::updateCategoryView() {
   QModelIndex index = categoryView->currentIndex();
 
   if (index.isValid()) {
-    QSqlRecord record = categoryModel->record(index.row());
-    QString categoryId = record.value("categoryId").toString();
-
-    categoryModelFilter = QString("categoryId = '%1'").arg(categoryId);
-    categoryModelFilterLabel =
-      tr("Category %1").arg(record.value("CategoryName").toString());
+    QString categoryId =
+      categoryModel->value(
+        index.row()
+        , CategoryMetricsView_CategoryId).toString();
+    QString categoryName =
+      categoryModel->value(
+        index.row()
+        , CategoryMetricsView_CategoryName).toString();
+
+    categoryModelFilter = keyFilter("categoryId", categoryId);
+    categoryModelFilterLabel = tr("Category %1").arg(categoryName);
 
     registerModelFilter = "";
     registerModelFilterLabel = "";
@@ -1827,8 +2419,7 @@ void MainForm::updateRegisterView() {
 }
 
 void MainForm::setFlowRestriction() {
-  QString modelFilter = (periodModelFilter != "" ? periodModelFilter : "");
-  flowModel->setFilter(modelFilter);
+  flowModel->setPeriodId(periodModelFilterId);
 
   QString modelFilterLabel =
     (periodModelFilterLabel != "" ? tr(" for ") + periodModelFilterLabel : "");
@@ -1837,13 +2428,8 @@ void MainForm::setFlowRestriction() {
 }
 
 void MainForm::setCategoryRestriction() {
-  QString modelFilter = (periodModelFilter != "" ? periodModelFilter : "");
-  modelFilter +=
-    (flowModelFilter != ""
-    ? (modelFilter != "" ? " and " : "")
-      + flowModelFilter
-    : "");
-  categoryModel->setFilter(modelFilter);
+  categoryModel->setPeriodId(periodModelFilterId);
+  categoryModel->setFlowId(flowModelFilterId);
 
   QString modelFilterLabel =
     (periodModelFilterLabel != "" ? tr(" for ") + periodModelFilterLabel : "");
@@ -2109,6 +2695,15 @@ void MainForm::writeSettings() const {
     settings.setValue("windowState", saveState());
     settings.endGroup();
   }
+
+  // keep the interval in the settings file, where it can be changed
+  QSettings settings("cashflow", "cashflow");
+
+  settings.beginGroup("Autosave");
+  settings.setValue(
+    "intervalMinutes"
+    , settings.value("intervalMinutes", AUTOSAVE_INTERVAL_MINUTES));
+  settings.endGroup();
 }
 
 void MainForm::readSettings() {
@@ -2126,6 +2721,19 @@ void MainForm::readSettings() {
   restoreState(settings.value("windowState").toByteArray());
 
   settings.endGroup();
+
+  settings.beginGroup("Autosave");
+
+  int autosaveMinutes =
+    settings.value("intervalMinutes", AUTOSAVE_INTERVAL_MINUTES).toInt();
+
+  settings.endGroup();
+
+  if (autosaveMinutes > 0) {
+    autosaveTimer->start(autosaveMinutes * 60 * 1000);
+  } else {
+    autosaveTimer->stop();
+  }
 }
 
 void MainForm::closeEvent(QCloseEvent *event) {
@@ -2258,28 +2866,17 @@ void MainForm::registerAllUnregisteredItems() {
         , QObject::tr("The period row is not valid."));
     } else {
       periodView->setFocus();
-  
-      quint32 totalUnusedItems = unusedModel->rowCount();
-  
-      QProgressDialog progress(
-        "Registering All Items...", "Cancel", 0, totalUnusedItems, this);
-  
-      progress.setWindowModality(Qt::WindowModal);
-  
-      quint32 itemsLeftToConsider = unusedModel->rowCount();
-  
-      while (itemsLeftToConsider > 0) {
-        progress.setValue(totalUnusedItems - unusedModel->rowCount());
-  
-        if (progress.wasCanceled())
-          break;
-  
-        registerItem();
 
-        itemsLeftToConsider--;
+      // register every unused item in one statement and one undo entry
+      QString periodId = periodModel->data(periodIdIndex).toString();
+
+      if (unusedModel->rowCount() > 0
+        && qApp->registerAllItems(periodId))
+      {
+        showChangedOccured();
+        reloadMetricsCache();
+        updateViewsAfterChange();
       }
-  
-      progress.setValue(registerModel->rowCount());
 
       unusedPanel->hide();
 
@@ -2301,46 +2898,73 @@ void MainForm::unregisterAllRegisteredItems() {
         , QObject::tr("Error: Row not valid.")
         , QObject::tr("The period row is not valid."));
     } else {
+      bool isRunningOkay = true;
+
       unusedPanel->show();
 
       periodView->setFocus();
-  
-      int totalRegisteredItems = registerModel->rowCount();
-  
-      QProgressDialog progress(
-        "Unregistering All Items...", "Cancel", 0, totalRegisteredItems, this);
-  
-      progress.setWindowModality(Qt::WindowModal);
-
-      unregisterChangedChoices = 
-        QMessageBox::Yes 
-        | QMessageBox::No 
-        | QMessageBox::YesToAll
-        | QMessageBox::NoToAll
-        | QMessageBox::Cancel;
-
-      unregisterChangedChoice = QMessageBox::NoButton;
-
-      int itemIndex = 0;
-      
-      while(
-        itemIndex < totalRegisteredItems
-        && !progress.wasCanceled()
-        && unregisterChangedChoice != QMessageBox::Cancel)
-      {
-        progress.setValue(itemIndex + 1);
-  
-        unregisterItem(
-          itemIndex - totalRegisteredItems + registerModel->rowCount());
 
-        ++itemIndex;
+      QString periodId = periodModel->data(periodIdIndex).toString();
+      QString periodName =
+        periodModel->record(modelIndex.row()).value("periodName").toString();
+
+      // find the changed entries up front, so there is only one question
+      int registerCount = 0;
+      QStringList changedItemNames =
+        qApp->changedRegisterItemNames(periodId, registerCount);
+
+      bool includeChanged = true;
+
+      if (registerCount == 0) {
+        isRunningOkay = false;
       }
 
-      unregisterChangedChoices = QMessageBox::Yes | QMessageBox::No;
-      unregisterChangedChoice = QMessageBox::NoButton;
+      if (isRunningOkay
+          && !changedItemNames.isEmpty()) {
+        const int listedItemLimit = 10;
+
+        QString listedItems =
+          QStringList(changedItemNames.mid(0, listedItemLimit)).join("\n");
 
+        if (changedItemNames.count() > listedItemLimit) {
+          listedItems +=
+            "\n" + tr("and %1 more")
+              .arg(changedItemNames.count() - listedItemLimit);
+        }
 
-      progress.setValue(totalRegisteredItems);
+        QMessageBox::StandardButton choice =
+          QMessageBox::warning(
+            this
+            , tr("Unregister All Entries")
+            , tr("%1 of the %2 entries for Period %3 contain changed values:"
+                "\n\n%4\n\n"
+                "Unregister the changed entries too?")
+              .arg(changedItemNames.count())
+              .arg(registerCount)
+              .arg(periodName)
+              .arg(listedItems)
+            , QMessageBox::Yes | QMessageBox::No | QMessageBox::Cancel);
+
+        if (choice == QMessageBox::Cancel) {
+          isRunningOkay = false;
+        }
+
+        includeChanged = (choice == QMessageBox::Yes);
+
+        // keeping every entry leaves nothing to unregister
+        if (!includeChanged
+            && changedItemNames.count() == registerCount) {
+          isRunningOkay = false;
+        }
+      }
+
+      // delete the chosen entries in one statement and one undo entry
+      if (isRunningOkay
+          && qApp->unregisterAllItems(periodId, includeChanged)) {
+        showChangedOccured();
+        reloadMetricsCache();
+        updateViewsAfterChange();
+      }
 
       unusedView->setFocus();
     }
@@ -2351,19 +2975,19 @@ void MainForm::validateRegisterModelMetrics(
   int row
   , QSqlRecord & registerRecord)
 {
-  double budget = registerRecord.value("budget").toDouble();
-  double actual = registerRecord.value("actual").toDouble();
+  qint64 budget = registerRecord.value("budget").toLongLong();
+  qint64 actual = registerRecord.value("actual").toLongLong();
 
   // if the budget value wasn't updated, grab it from the record
   if (!registerRecord.isGenerated("budget")) {
     QSqlRecord registerRecord = registerModel->record(row);
-    budget = registerRecord.value("budget").toDouble();
+    budget = registerRecord.value("budget").toLongLong();
   }
 
   // if the actual value wasn't updated, grab it from the record
   if (!registerRecord.isGenerated("actual")) {
     QSqlRecord registerRecord = registerModel->record(row);
-    actual = registerRecord.value("actual").toDouble();
+    actual = registerRecord.value("actual").toLongLong();
   }
 
   QString rules = 
@@ -2404,3 +3028,52 @@ void MainForm::validateRegisterModelMetrics(
     QMessageBox::information(this, QObject::tr("Validation Rules"), rules);
   }
 }
+
+void MainForm::reloadMetricsCache() {
+  if (!qApp->reloadMetricsCache()) {
+    QMessageBox::warning(
+      (QWidget *)0
+      , QObject::tr("Error: Loading the metrics cache failed.")
+      , QObject::tr("There was an error with loading the metrics cache."));
+  }
+}
+
+void MainForm::updateMetricsCacheBeforeInsert(QSqlRecord &registerRecord) {
+  qApp->getMetricsCache()->insertRegister(
+    registerRecord.value("registerId").toString()
+    , registerRecord.value("periodId").toString()
+    , registerRecord.value("itemId").toString()
+    , registerRecord.value("budget").toLongLong()
+    , registerRecord.value("actual").toLongLong());
+}
+
+void MainForm::updateMetricsCacheBeforeUpdate(
+  int row
+  , QSqlRecord &registerRecord)
+{
+  QSqlRecord currentRecord = registerModel->record(row);
+
+  qint64 budget = currentRecord.value("budget").toLongLong();
+  qint64 actual = currentRecord.value("actual").toLongLong();
+
+  // only the generated fields carry new values
+  if (registerRecord.isGenerated("budget")) {
+    budget = registerRecord.value("budget").toLongLong();
+  }
+
+  if (registerRecord.isGenerated("actual")) {
+    actual = registerRecord.value("actual").toLongLong();
+  }
+
+  qApp->getMetricsCache()->updateRegister(
+    currentRecord.value("registerId").toString()
+    , budget
+    , actual);
+}
+
+void MainForm::updateMetricsCacheBeforeDelete(int row) {
+  QSqlRecord currentRecord = registerModel->record(row);
+
+  qApp->getMetricsCache()->removeRegister(
+    currentRecord.value("registerId").toString());
+}
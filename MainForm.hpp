@@ -23,6 +23,8 @@
 	#include <QSqlRelationalTableModel>
 	#include <QTableView>
 
+	#include "Exporter.hpp"
+	#include "MetricsModel.hpp"
 	#include "SqlTableModel.hpp"
 
 	class	QAction;
@@ -33,10 +35,12 @@
 	class	QLabel;
 	class	QMenu;
 	class	QModelIndex;
+	class	QProgressBar;
 	class	QPushButton;
 	class	QShortcut;
 	class	QSplitter;
 	class	QSqlTableModel;
+	class	QTimer;
 	class QToolBar;
 	class	QVBoxLayout;
 
@@ -80,11 +84,15 @@
 
   		void newFile();
   		void open(QString	fileName = QString());
+  		void openReadOnly();
   		void revertToSave();
   		void closeFile();
   		void save();
   		void saveAs();
   		void backupAs();
+  		void autosave();
+  		void saveFinished();
+  		void offerRecovery();
   		void openRecentFile();
   		void openRecentFileByIndex(int index);
   		void properties();
@@ -92,12 +100,17 @@
 
   		void manageCategories();
   		void manageItems();
+  		void importStatement();
+  		void exportRegister();
+  		void exportPeriods();
+  		void consolidatedReport();
 
   		void undo();
   		void redo();
 
   		void addPeriod(QString periodName = "");
   		void clonePeriod();
+  		void generatePeriods();
   		void deletePeriod();
 
   		void registerItem();
@@ -140,8 +153,16 @@
 
       void validateRegisterModelMetrics(int, QSqlRecord &);
 
+      void reloadMetricsCache();
+      void updateMetricsCacheBeforeInsert(QSqlRecord &);
+      void updateMetricsCacheBeforeUpdate(int, QSqlRecord &);
+      void updateMetricsCacheBeforeDelete(int);
+
   	private:
   		bool okToContinue();
+  		void showSaveStarted(QString message);
+  		void setEditingEnabled(bool isEnabled);
+  		void exportSource(Exporter::Source source, QString caption);
   		void addCurrentFileToRecentList();
   		void getRecentFiles();
 
@@ -192,8 +213,8 @@
       void showFileToolBar();
 
   		SqlTableModel	*periodModel;
-  		SqlTableModel	*flowModel;
-  		SqlTableModel	*categoryModel;
+  		MetricsModel	*flowModel;
+  		MetricsModel	*categoryModel;
   		SqlTableModel	*registerModel;
   		SqlTableModel	*unusedModel;
 
@@ -232,6 +253,8 @@
 
   		QString	periodModelFilter;
   		QString	flowModelFilter;
+  		QString	periodModelFilterId;
+  		QString	flowModelFilterId;
   		QString	categoryModelFilter;
   		QString	registerModelFilter;
 
@@ -252,6 +275,7 @@
 
   		QAction	*newAction;
   		QAction	*openAction;
+  		QAction	*openReadOnlyAction;
   		QAction	*revertAction;
   		QAction	*closeAction;
   		QAction	*saveAction;
@@ -259,6 +283,10 @@
   		QAction	*backupAsAction;
   		QAction	*manageCategoriesAction;
   		QAction	*manageItemsAction;
+  		QAction	*importStatementAction;
+  		QAction	*exportRegisterAction;
+  		QAction	*exportPeriodsAction;
+  		QAction	*consolidatedReportAction;
   		QAction	*recentFileActions[MaxRecentFiles];
   		QAction	*seperatorAction;
 
@@ -268,6 +296,7 @@
   		QAction	*redoAction;
   		QAction	*addPeriodAction;
   		QAction	*clonePeriodAction;
+  		QAction	*generatePeriodsAction;
   		QAction	*deletePeriodAction;
   		QAction	*registerItemAction;
   		QAction	*registerAllItemsAction;
@@ -302,6 +331,9 @@
       QToolBar *viewToolBar;
 
       QComboBox *recentFilesComboBox;
+
+      QTimer *autosaveTimer;
+      QProgressBar *saveProgressBar;
       
       QMessageBox::StandardButtons unregisterChangedChoices;
       enum QMessageBox::StandardButton unregisterChangedChoice;
@@ -30,7 +30,7 @@ using Cashflow::SqlTableModel;
 using Cashflow::TableView;
 
 ManageCategoriesForm::ManageCategoriesForm(
-    int id, QWidget *parent) : QDialog(parent) {
+    QString id, QWidget *parent) : QDialog(parent) {
 
   inCategoryModel = new SqlTableModel(this);
   inCategoryModel->setTable("inCategoryMapView");
@@ -151,14 +151,14 @@ ManageCategoriesForm::ManageCategoriesForm(
   mainLayout->addWidget(mainButtonBox);
   setLayout(mainLayout);
 
-  if (id != -1) {
+  if (!id.isEmpty()) {
     bool isRowFound = false;
 
     int inRow = 0;
 
     while (inRow < inCategoryModel->rowCount() && !isRowFound) {
       QSqlRecord record = inCategoryModel->record(inRow);
-      if (record.value(CategoryMapView_CategoryId).toInt() == id) {
+      if (record.value(CategoryMapView_CategoryId).toString() == id) {
         isRowFound = true;
 
         inCategoryView->selectRow(inRow);
@@ -172,7 +172,7 @@ ManageCategoriesForm::ManageCategoriesForm(
 
     while (outRow < outCategoryModel->rowCount() && !isRowFound) {
       QSqlRecord record = outCategoryModel->record(outRow);
-      if (record.value(CategoryMapView_CategoryId).toInt() == id) {
+      if (record.value(CategoryMapView_CategoryId).toString() == id) {
         isRowFound = true;
 
         outCategoryView->selectRow(outRow);
@@ -60,7 +60,7 @@
       Q_OBJECT
   
     public:
-      ManageCategoriesForm(int id, QWidget *parent = (QWidget *)0);
+      ManageCategoriesForm(QString id, QWidget *parent = (QWidget *)0);
   
     public slots:
       void done(int result);
@@ -30,7 +30,7 @@ using Cashflow::SqlTableModel;
 using Cashflow::TableView;
 
 ManageItemsForm::ManageItemsForm(
-    int id, QWidget *parent) : QDialog(parent) {
+    QString id, QWidget *parent) : QDialog(parent) {
 
   categoryModel = new SqlTableModel(this);
   categoryModel->setTable("categoryMapView");
@@ -137,14 +137,14 @@ ManageItemsForm::ManageItemsForm(
   mainLayout->addWidget(mainItemButtonBox);
   setLayout(mainLayout);
 
-  if (id != -1) {
+  if (!id.isEmpty()) {
     bool isRowFound = false;
 
     int row = 0;
 
     while (row < categoryModel->rowCount() && !isRowFound) {
       QSqlRecord record = categoryModel->record(row);
-      if (record.value(CategoryMapView_CategoryId).toInt() == id) {
+      if (record.value(CategoryMapView_CategoryId).toString() == id) {
         isRowFound = true;
 
         categoryView->selectRow(row);
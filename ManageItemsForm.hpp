@@ -82,7 +82,7 @@
       Q_OBJECT
   
     public:
-      ManageItemsForm(int id, QWidget *parent = (QWidget *)0);
+      ManageItemsForm(QString id, QWidget *parent = (QWidget *)0);
   
     public slots:
       void done(int result);
@@ -0,0 +1,441 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  MetricsCache class source
+//    This class keeps the register in memory as columns and rolls it up by
+//    period and flow and by period and category for the summary panels.
+
+#include <QtGui>
+#include <QtSql>
+#include <QDebug>
+
+#include "cashflow.hpp"
+#include "MetricsCache.hpp"
+
+using Cashflow::MetricsCache;
+
+static bool selectForward(QSqlQuery &query, QString statement) {
+  bool isRunningOkay = true;
+
+  query.setForwardOnly(true);
+
+  if (!query.exec(statement)) {
+    QString title =
+      QObject::tr("Error Type=")
+      + query.lastError().type()
+      + " "
+      + QObject::tr("Could not load the metrics cache.");
+    QString text = ATLINE + ":" + query.lastError().text();
+
+    // a command-line export loads the cache without a window to warn in
+    if (QApplication::type() == QApplication::Tty) {
+      qWarning("%s %s", qPrintable(title), qPrintable(text));
+    } else {
+      QMessageBox::warning((QWidget *)0, title, text);
+    }
+
+    isRunningOkay = false;
+  }
+
+  return isRunningOkay;
+}
+
+MetricsCache::MetricsCache() {
+  // intentionally empty function
+}
+
+bool MetricsCache::load() {
+  bool isRunningOkay = true;
+
+  clear();
+
+  if (isRunningOkay) {
+    QSqlQuery query;
+    isRunningOkay = selectForward(
+      query
+      , "select\n"
+        "  id\n"
+        "  , name\n"
+        "from\n"
+        "  period\n");
+
+    while (isRunningOkay && query.next()) {
+      periodIndexes.insert(query.value(0).toString(), periodIds.count());
+      periodIds << query.value(0).toString();
+      periodNames << query.value(1).toString();
+    }
+  }
+
+  if (isRunningOkay) {
+    QSqlQuery query;
+    isRunningOkay = selectForward(
+      query
+      , "select\n"
+        "  id\n"
+        "  , name\n"
+        "from\n"
+        "  flow\n");
+
+    while (isRunningOkay && query.next()) {
+      flowIndexes.insert(query.value(0).toString(), flowIds.count());
+      flowIds << query.value(0).toString();
+      flowNames << query.value(1).toString();
+    }
+  }
+
+  if (isRunningOkay) {
+    QSqlQuery query;
+    isRunningOkay = selectForward(
+      query
+      , "select\n"
+        "  id\n"
+        "  , name\n"
+        "  , flowId\n"
+        "from\n"
+        "  category\n");
+
+    while (isRunningOkay && query.next()) {
+      categoryIndexes.insert(query.value(0).toString(), categoryIds.count());
+      categoryIds << query.value(0).toString();
+      categoryNames << query.value(1).toString();
+      categoryFlowIndexes << flowIndexes.value(query.value(2).toString(), -1);
+    }
+  }
+
+  if (isRunningOkay) {
+    QSqlQuery query;
+    isRunningOkay = selectForward(
+      query
+      , "select\n"
+        "  id\n"
+        "  , categoryId\n"
+        "from\n"
+        "  item\n");
+
+    while (isRunningOkay && query.next()) {
+      itemIndexes.insert(query.value(0).toString(), itemCategoryIndexes.count());
+      itemCategoryIndexes
+        << categoryIndexes.value(query.value(1).toString(), -1);
+    }
+  }
+
+  if (isRunningOkay) {
+    QSqlQuery query;
+    isRunningOkay = selectForward(
+      query
+      , "select\n"
+        "  id\n"
+        "  , periodId\n"
+        "  , itemId\n"
+        "  , budget\n"
+        "  , actual\n"
+        "from\n"
+        "  register\n");
+
+    while (isRunningOkay && query.next()) {
+      int periodIndex = periodIndexes.value(query.value(1).toString(), -1);
+      int itemIndex = itemIndexes.value(query.value(2).toString(), -1);
+
+      // the foreign keys keep these valid, but never index out of range
+      if (periodIndex < 0
+        || itemIndex < 0
+        || itemCategoryIndexes[itemIndex] < 0)
+      {
+        continue;
+      }
+
+      registerRows.insert(query.value(0).toString(), registerIds.count());
+      registerIds << query.value(0).toString();
+      registerPeriodIndexes << periodIndex;
+      registerItemIndexes << itemIndex;
+      registerBudgets << query.value(3).toLongLong();
+      registerActuals << query.value(4).toLongLong();
+    }
+  }
+
+  if (isRunningOkay) {
+    computeRollups();
+  } else {
+    clear();
+  }
+
+  return isRunningOkay;
+}
+
+void MetricsCache::clear() {
+  periodIds.clear();
+  periodNames.clear();
+  periodIndexes.clear();
+
+  flowIds.clear();
+  flowNames.clear();
+  flowIndexes.clear();
+
+  categoryIds.clear();
+  categoryNames.clear();
+  categoryFlowIndexes.clear();
+  categoryIndexes.clear();
+
+  itemCategoryIndexes.clear();
+  itemIndexes.clear();
+
+  registerIds.clear();
+  registerPeriodIndexes.clear();
+  registerItemIndexes.clear();
+  registerBudgets.clear();
+  registerActuals.clear();
+  registerRows.clear();
+
+  flowRegisterCounts.clear();
+  flowBudgets.clear();
+  flowActuals.clear();
+
+  categoryRegisterCounts.clear();
+  categoryBudgets.clear();
+  categoryActuals.clear();
+}
+
+void MetricsCache::computeRollups() {
+  const int categoryCells = periodIds.count() * categoryIds.count();
+  const int flowCells = periodIds.count() * flowIds.count();
+
+  categoryRegisterCounts.fill(0, categoryCells);
+  categoryBudgets.fill(0, categoryCells);
+  categoryActuals.fill(0, categoryCells);
+
+  flowRegisterCounts.fill(0, flowCells);
+  flowBudgets.fill(0, flowCells);
+  flowActuals.fill(0, flowCells);
+
+  // one pass over the register columns into the category cells
+  const int rowCount = registerIds.count();
+  const int categoryTotal = categoryIds.count();
+
+  const int *periods = registerPeriodIndexes.constData();
+  const int *items = registerItemIndexes.constData();
+  const int *itemCategories = itemCategoryIndexes.constData();
+  const qint64 *budgets = registerBudgets.constData();
+  const qint64 *actuals = registerActuals.constData();
+
+  int *cellCounts = categoryRegisterCounts.data();
+  qint64 *cellBudgets = categoryBudgets.data();
+  qint64 *cellActuals = categoryActuals.data();
+
+  for (int row = 0; row < rowCount; ++row) {
+    const int cell = periods[row] * categoryTotal + itemCategories[items[row]];
+
+    ++cellCounts[cell];
+    cellBudgets[cell] += budgets[row];
+    cellActuals[cell] += actuals[row];
+  }
+
+  // fold the category cells into their flows
+  const int flowTotal = flowIds.count();
+
+  for (int period = 0; period < periodIds.count(); ++period) {
+    for (int category = 0; category < categoryTotal; ++category) {
+      const int flow = categoryFlowIndexes[category];
+
+      if (flow < 0) {
+        continue;
+      }
+
+      const int categoryCell = period * categoryTotal + category;
+      const int flowCell = period * flowTotal + flow;
+
+      flowRegisterCounts[flowCell] += cellCounts[categoryCell];
+      flowBudgets[flowCell] += cellBudgets[categoryCell];
+      flowActuals[flowCell] += cellActuals[categoryCell];
+    }
+  }
+}
+
+void MetricsCache::applyRegisterRow(int row, int sign) {
+  const int period = registerPeriodIndexes[row];
+  const int category = itemCategoryIndexes[registerItemIndexes[row]];
+  const int flow = categoryFlowIndexes[category];
+
+  const int categoryCell = period * categoryIds.count() + category;
+
+  categoryRegisterCounts[categoryCell] += sign;
+  categoryBudgets[categoryCell] += sign * registerBudgets[row];
+  categoryActuals[categoryCell] += sign * registerActuals[row];
+
+  if (flow >= 0) {
+    const int flowCell = period * flowIds.count() + flow;
+
+    flowRegisterCounts[flowCell] += sign;
+    flowBudgets[flowCell] += sign * registerBudgets[row];
+    flowActuals[flowCell] += sign * registerActuals[row];
+  }
+}
+
+void MetricsCache::insertRegister(
+  QString registerId
+  , QString periodId
+  , QString itemId
+  , qint64 budget
+  , qint64 actual)
+{
+  if (registerRows.contains(registerId)) {
+    removeRegister(registerId);
+  }
+
+  // a period or item added since the last load needs the dimensions reloaded
+  if (!periodIndexes.contains(periodId) || !itemIndexes.contains(itemId)) {
+    load();
+  }
+
+  int periodIndex = periodIndexes.value(periodId, -1);
+  int itemIndex = itemIndexes.value(itemId, -1);
+
+  if (periodIndex >= 0
+    && itemIndex >= 0
+    && itemCategoryIndexes[itemIndex] >= 0)
+  {
+    int row = registerIds.count();
+
+    registerRows.insert(registerId, row);
+    registerIds << registerId;
+    registerPeriodIndexes << periodIndex;
+    registerItemIndexes << itemIndex;
+    registerBudgets << budget;
+    registerActuals << actual;
+
+    applyRegisterRow(row, 1);
+  }
+}
+
+void MetricsCache::updateRegister(
+  QString registerId
+  , qint64 budget
+  , qint64 actual)
+{
+  int row = registerRows.value(registerId, -1);
+
+  if (row >= 0) {
+    applyRegisterRow(row, -1);
+
+    registerBudgets[row] = budget;
+    registerActuals[row] = actual;
+
+    applyRegisterRow(row, 1);
+  }
+}
+
+void MetricsCache::removeRegister(QString registerId) {
+  int row = registerRows.value(registerId, -1);
+
+  if (row >= 0) {
+    applyRegisterRow(row, -1);
+
+    // move the last row into the hole to keep the columns dense
+    int lastRow = registerIds.count() - 1;
+
+    if (row != lastRow) {
+      registerIds[row] = registerIds[lastRow];
+      registerPeriodIndexes[row] = registerPeriodIndexes[lastRow];
+      registerItemIndexes[row] = registerItemIndexes[lastRow];
+      registerBudgets[row] = registerBudgets[lastRow];
+      registerActuals[row] = registerActuals[lastRow];
+
+      registerRows.insert(registerIds[row], row);
+    }
+
+    registerRows.remove(registerId);
+    registerIds.removeLast();
+    registerPeriodIndexes.remove(lastRow);
+    registerItemIndexes.remove(lastRow);
+    registerBudgets.remove(lastRow);
+    registerActuals.remove(lastRow);
+  }
+}
+
+int MetricsCache::periodCount() const {
+  return periodIds.count();
+}
+
+int MetricsCache::flowCount() const {
+  return flowIds.count();
+}
+
+int MetricsCache::categoryCount() const {
+  return categoryIds.count();
+}
+
+int MetricsCache::periodIndex(QString periodId) const {
+  return periodIndexes.value(periodId, -1);
+}
+
+int MetricsCache::flowIndex(QString flowId) const {
+  return flowIndexes.value(flowId, -1);
+}
+
+QString MetricsCache::periodId(int periodIndex) const {
+  return periodIds.value(periodIndex);
+}
+
+QString MetricsCache::periodName(int periodIndex) const {
+  return periodNames.value(periodIndex);
+}
+
+QString MetricsCache::flowId(int flowIndex) const {
+  return flowIds.value(flowIndex);
+}
+
+QString MetricsCache::flowName(int flowIndex) const {
+  return flowNames.value(flowIndex);
+}
+
+QString MetricsCache::categoryId(int categoryIndex) const {
+  return categoryIds.value(categoryIndex);
+}
+
+QString MetricsCache::categoryName(int categoryIndex) const {
+  return categoryNames.value(categoryIndex);
+}
+
+int MetricsCache::categoryFlowIndex(int categoryIndex) const {
+  return categoryFlowIndexes.value(categoryIndex, -1);
+}
+
+int MetricsCache::flowRegisterCount(int periodIndex, int flowIndex) const {
+  return flowRegisterCounts.value(periodIndex * flowIds.count() + flowIndex);
+}
+
+qint64 MetricsCache::flowBudget(int periodIndex, int flowIndex) const {
+  return flowBudgets.value(periodIndex * flowIds.count() + flowIndex);
+}
+
+qint64 MetricsCache::flowActual(int periodIndex, int flowIndex) const {
+  return flowActuals.value(periodIndex * flowIds.count() + flowIndex);
+}
+
+int MetricsCache::categoryRegisterCount(
+  int periodIndex
+  , int categoryIndex) const
+{
+  return categoryRegisterCounts.value(
+    periodIndex * categoryIds.count() + categoryIndex);
+}
+
+qint64 MetricsCache::categoryBudget(int periodIndex, int categoryIndex) const {
+  return categoryBudgets.value(
+    periodIndex * categoryIds.count() + categoryIndex);
+}
+
+qint64 MetricsCache::categoryActual(int periodIndex, int categoryIndex) const {
+  return categoryActuals.value(
+    periodIndex * categoryIds.count() + categoryIndex);
+}
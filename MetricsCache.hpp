@@ -0,0 +1,106 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  MetricsCache class definition
+//    This class keeps the register in memory as columns and rolls it up by
+//    period and flow and by period and category for the summary panels.
+
+#ifndef _CASHFLOW_METRICSCACHE_HPP_
+  #define _CASHFLOW_METRICSCACHE_HPP_
+
+  #include <QHash>
+  #include <QString>
+  #include <QStringList>
+  #include <QVector>
+
+  namespace Cashflow {
+    class MetricsCache {
+    public:
+      MetricsCache();
+
+      bool load();
+      void clear();
+
+      void insertRegister(
+        QString registerId
+        , QString periodId
+        , QString itemId
+        , qint64 budget
+        , qint64 actual);
+      void updateRegister(QString registerId, qint64 budget, qint64 actual);
+      void removeRegister(QString registerId);
+
+      int periodCount() const;
+      int flowCount() const;
+      int categoryCount() const;
+
+      int periodIndex(QString periodId) const;
+      int flowIndex(QString flowId) const;
+
+      QString periodId(int periodIndex) const;
+      QString periodName(int periodIndex) const;
+      QString flowId(int flowIndex) const;
+      QString flowName(int flowIndex) const;
+      QString categoryId(int categoryIndex) const;
+      QString categoryName(int categoryIndex) const;
+      int categoryFlowIndex(int categoryIndex) const;
+
+      int flowRegisterCount(int periodIndex, int flowIndex) const;
+      qint64 flowBudget(int periodIndex, int flowIndex) const;
+      qint64 flowActual(int periodIndex, int flowIndex) const;
+
+      int categoryRegisterCount(int periodIndex, int categoryIndex) const;
+      qint64 categoryBudget(int periodIndex, int categoryIndex) const;
+      qint64 categoryActual(int periodIndex, int categoryIndex) const;
+
+    private:
+      void computeRollups();
+      void applyRegisterRow(int row, int sign);
+
+      // dimensions
+      QStringList periodIds;
+      QStringList periodNames;
+      QHash<QString, int> periodIndexes;
+
+      QStringList flowIds;
+      QStringList flowNames;
+      QHash<QString, int> flowIndexes;
+
+      QStringList categoryIds;
+      QStringList categoryNames;
+      QVector<int> categoryFlowIndexes;
+      QHash<QString, int> categoryIndexes;
+
+      QVector<int> itemCategoryIndexes;
+      QHash<QString, int> itemIndexes;
+
+      // register columns, one entry per register row
+      QStringList registerIds;
+      QVector<int> registerPeriodIndexes;
+      QVector<int> registerItemIndexes;
+      QVector<qint64> registerBudgets;
+      QVector<qint64> registerActuals;
+      QHash<QString, int> registerRows;
+
+      // rollups, indexed by period index * dimension count + dimension index
+      QVector<int> flowRegisterCounts;
+      QVector<qint64> flowBudgets;
+      QVector<qint64> flowActuals;
+
+      QVector<int> categoryRegisterCounts;
+      QVector<qint64> categoryBudgets;
+      QVector<qint64> categoryActuals;
+    };
+  }
+#endif // _CASHFLOW_METRICSCACHE_HPP_
@@ -0,0 +1,332 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  MetricsModel class source
+//    This class shows the flow or category rollups of the metrics cache with
+//    the same columns as the flowMetricsView and categoryMetricsView.
+
+#include <QtGui>
+#include <QDebug>
+
+#include "cashflow.hpp"
+#include "MainForm.hpp"
+#include "ManageCategoriesForm.hpp"
+#include "MetricsModel.hpp"
+
+using Cashflow::MetricsModel;
+
+// orders row positions by a precomputed sort key per row
+class SortKeyLessThan {
+public:
+  SortKeyLessThan(const QVector<QVariant> &keys, Qt::SortOrder order)
+    : keys(keys), order(order) {}
+
+  bool operator()(int left, int right) const {
+    const QVariant &leftKey = keys[left];
+    const QVariant &rightKey = keys[right];
+
+    int compare = 0;
+
+    if (leftKey.type() == QVariant::LongLong) {
+      qint64 leftValue = leftKey.toLongLong();
+      qint64 rightValue = rightKey.toLongLong();
+      compare =
+        (leftValue < rightValue ? -1 : (rightValue < leftValue ? 1 : 0));
+    } else {
+      compare =
+        QString::localeAwareCompare(leftKey.toString(), rightKey.toString());
+    }
+
+    return (order == Qt::AscendingOrder ? compare < 0 : compare > 0);
+  }
+
+private:
+  const QVector<QVariant> &keys;
+  Qt::SortOrder order;
+};
+
+MetricsModel::MetricsModel(
+  MetricsCache *cache
+  , Level level
+  , QObject *parent)
+  : QAbstractTableModel(parent)
+  , cache(cache)
+  , level(level)
+  , sortColumn(-1)
+  , sortOrder(Qt::AscendingOrder)
+{
+  // intentionally empty function
+}
+
+int MetricsModel::rowCount(const QModelIndex &parent) const {
+  return (parent.isValid() ? 0 : rows.count());
+}
+
+int MetricsModel::columnCount(const QModelIndex &parent) const {
+  int columns =
+    (level == FlowLevel
+    ? FlowMetricsView_Difference + 1
+    : CategoryMetricsView_Difference + 1);
+
+  return (parent.isValid() ? 0 : columns);
+}
+
+QVariant MetricsModel::data(const QModelIndex &index, int role) const {
+  QVariant returnValue;
+
+  if (!index.isValid() || index.row() >= rows.count()) {
+    return returnValue;
+  }
+
+  bool isNumeric =
+    (level == FlowLevel
+    ? index.column() >= FlowMetricsView_Budget
+    : index.column() >= CategoryMetricsView_Budget);
+
+  if (role == Qt::DisplayRole || role == Qt::EditRole) {
+    returnValue = rowValue(rows[index.row()], index.column());
+  }
+  else if (role == Qt::TextAlignmentRole) {
+    if (isNumeric) {
+      returnValue = (int)(Qt::AlignRight | Qt::AlignVCenter);
+    }
+  }
+  // the rollups are read-only, so shade them like the other metric views
+  else if (role == Qt::BackgroundRole) {
+    returnValue = QVariant(QColor(224, 224, 224));
+  }
+  else if (role == Qt::ForegroundRole) {
+    returnValue = QVariant(QColor(42, 42, 42));
+  }
+
+  return returnValue;
+}
+
+QVariant MetricsModel::headerData(
+  int section
+  , Qt::Orientation orientation
+  , int role) const
+{
+  if (orientation == Qt::Horizontal
+    && (role == Qt::DisplayRole || role == Qt::EditRole)
+    && headers.contains(section))
+  {
+    return headers.value(section);
+  }
+
+  return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+bool MetricsModel::setHeaderData(
+  int section
+  , Qt::Orientation orientation
+  , const QVariant &value
+  , int role)
+{
+  bool isRunningOkay = true;
+
+  if (orientation != Qt::Horizontal
+    || (role != Qt::DisplayRole && role != Qt::EditRole)
+    || section < 0
+    || section >= columnCount())
+  {
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    headers.insert(section, value);
+    emit headerDataChanged(orientation, section, section);
+  }
+
+  return isRunningOkay;
+}
+
+void MetricsModel::sort(int column, Qt::SortOrder order) {
+  setSort(column, order);
+  select();
+}
+
+void MetricsModel::setSort(int column, Qt::SortOrder order) {
+  sortColumn = column;
+  sortOrder = order;
+}
+
+void MetricsModel::setPeriodId(QString periodId) {
+  this->periodId = periodId;
+  select();
+}
+
+void MetricsModel::setFlowId(QString flowId) {
+  this->flowId = flowId;
+  select();
+}
+
+bool MetricsModel::select() {
+  beginResetModel();
+
+  rows.clear();
+
+  int firstPeriod = 0;
+  int endPeriod = cache->periodCount();
+
+  if (!periodId.isEmpty()) {
+    firstPeriod = cache->periodIndex(periodId);
+    endPeriod = (firstPeriod < 0 ? firstPeriod : firstPeriod + 1);
+  }
+
+  int flowIndex = (flowId.isEmpty() ? -1 : cache->flowIndex(flowId));
+
+  for (int period = firstPeriod; period < endPeriod; ++period) {
+    if (level == FlowLevel) {
+      for (int flow = 0; flow < cache->flowCount(); ++flow) {
+        if (cache->flowRegisterCount(period, flow) > 0) {
+          Row row = { period, flow };
+          rows << row;
+        }
+      }
+    } else {
+      for (int category = 0; category < cache->categoryCount(); ++category) {
+        if (!flowId.isEmpty()
+          && cache->categoryFlowIndex(category) != flowIndex)
+        {
+          continue;
+        }
+
+        if (cache->categoryRegisterCount(period, category) > 0) {
+          Row row = { period, category };
+          rows << row;
+        }
+      }
+    }
+  }
+
+  sortRows();
+
+  endResetModel();
+
+  return true;
+}
+
+QVariant MetricsModel::value(int row, int column) const {
+  return (
+    row >= 0 && row < rows.count()
+    ? rowValue(rows[row], column)
+    : QVariant());
+}
+
+QVariant MetricsModel::rowValue(const Row &row, int column) const {
+  QVariant returnValue;
+
+  int period = row.periodIndex;
+
+  if (level == FlowLevel) {
+    int flow = row.dimensionIndex;
+
+    qint64 budget = cache->flowBudget(period, flow);
+    qint64 actual = cache->flowActual(period, flow);
+
+    switch (column) {
+    case FlowMetricsView_PeriodId:
+      returnValue = cache->periodId(period);
+      break;
+    case FlowMetricsView_FlowId:
+      returnValue = cache->flowId(flow);
+      break;
+    case FlowMetricsView_PeriodName:
+      returnValue = cache->periodName(period);
+      break;
+    case FlowMetricsView_FlowName:
+      returnValue = cache->flowName(flow);
+      break;
+    case FlowMetricsView_Budget:
+      returnValue = budget;
+      break;
+    case FlowMetricsView_Actual:
+      returnValue = actual;
+      break;
+    case FlowMetricsView_Difference:
+      returnValue = budget - actual;
+      break;
+    }
+  } else {
+    int category = row.dimensionIndex;
+    int flow = cache->categoryFlowIndex(category);
+
+    qint64 budget = cache->categoryBudget(period, category);
+    qint64 actual = cache->categoryActual(period, category);
+
+    switch (column) {
+    case CategoryMetricsView_PeriodId:
+      returnValue = cache->periodId(period);
+      break;
+    case CategoryMetricsView_FlowId:
+      returnValue = cache->flowId(flow);
+      break;
+    case CategoryMetricsView_CategoryId:
+      returnValue = cache->categoryId(category);
+      break;
+    case CategoryMetricsView_PeriodName:
+      returnValue = cache->periodName(period);
+      break;
+    case CategoryMetricsView_FlowName:
+      returnValue = cache->flowName(flow);
+      break;
+    case CategoryMetricsView_CategoryName:
+      returnValue = cache->categoryName(category);
+      break;
+    case CategoryMetricsView_Budget:
+      returnValue = budget;
+      break;
+    case CategoryMetricsView_Actual:
+      returnValue = actual;
+      break;
+    case CategoryMetricsView_Difference:
+      returnValue = budget - actual;
+      break;
+    }
+  }
+
+  return returnValue;
+}
+
+void MetricsModel::sortRows() {
+  if (sortColumn < 0 || sortColumn >= columnCount() || rows.count() < 2) {
+    return;
+  }
+
+  QVector<QVariant> keys;
+  QVector<int> positions;
+
+  keys.reserve(rows.count());
+  positions.reserve(rows.count());
+
+  for (int position = 0; position < rows.count(); ++position) {
+    keys << rowValue(rows[position], sortColumn);
+    positions << position;
+  }
+
+  qStableSort(
+    positions.begin()
+    , positions.end()
+    , SortKeyLessThan(keys, sortOrder));
+
+  QVector<Row> sortedRows;
+  sortedRows.reserve(rows.count());
+
+  for (int position = 0; position < positions.count(); ++position) {
+    sortedRows << rows[positions[position]];
+  }
+
+  rows = sortedRows;
+}
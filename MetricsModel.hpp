@@ -0,0 +1,90 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  MetricsModel class definition
+//    This class shows the flow or category rollups of the metrics cache with
+//    the same columns as the flowMetricsView and categoryMetricsView.
+
+#ifndef _METRICSMODEL_HPP_
+  #define _METRICSMODEL_HPP_
+
+  #include <QAbstractTableModel>
+  #include <QHash>
+  #include <QString>
+  #include <QVector>
+
+  #include "MetricsCache.hpp"
+
+  namespace Cashflow {
+    class MetricsModel : public QAbstractTableModel {
+      Q_OBJECT
+    public:
+      enum Level {
+        FlowLevel
+        , CategoryLevel
+      };
+
+      MetricsModel(
+        MetricsCache *cache
+        , Level level
+        , QObject *parent = (QObject *)0);
+
+      int rowCount(const QModelIndex &parent = QModelIndex()) const;
+      int columnCount(const QModelIndex &parent = QModelIndex()) const;
+
+      QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+      QVariant headerData(
+        int section
+        , Qt::Orientation orientation
+        , int role = Qt::DisplayRole) const;
+      bool setHeaderData(
+        int section
+        , Qt::Orientation orientation
+        , const QVariant &value
+        , int role = Qt::EditRole);
+
+      void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+      void setSort(int column, Qt::SortOrder order);
+
+      void setPeriodId(QString periodId);
+      void setFlowId(QString flowId);
+
+      bool select();
+
+      QVariant value(int row, int column) const;
+
+    private:
+      struct Row {
+        int periodIndex;
+        int dimensionIndex;
+      };
+
+      QVariant rowValue(const Row &row, int column) const;
+      void sortRows();
+
+      MetricsCache *cache;
+      Level level;
+
+      QString periodId;
+      QString flowId;
+
+      int sortColumn;
+      Qt::SortOrder sortOrder;
+
+      QVector<Row> rows;
+      QHash<int, QVariant> headers;
+    };
+  }
+#endif // _METRICSMODEL_HPP_
@@ -0,0 +1,127 @@
+//  Copyright 2014 Jason Eric Timms
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  PayeeRulesForm class source
+//    The class that asks which item each unmatched payee of an imported
+//    statement goes to, and keeps the answers as payee rules.
+
+#include <QtGui>
+#include <QtSql>
+
+#include "PayeeRulesForm.hpp"
+
+using Cashflow::PayeeRulesForm;
+
+enum {
+  PayeeRules_Pattern = 0
+  , PayeeRules_Item = 1
+};
+
+PayeeRulesForm::PayeeRulesForm(
+    QStringList payees, QWidget *parent) : QDialog(parent) {
+
+  // every item is offered by category, with the first entry leaving the
+  // payee out of the import
+  QStringList itemNames;
+  QStringList itemIds;
+
+  itemNames << tr("(skip)");
+  itemIds << QString();
+
+  QSqlQuery query;
+  query.setForwardOnly(true);
+  query.exec(
+    "select\n"
+    "  itemId\n"
+    "  , categoryName\n"
+    "  , itemName\n"
+    "from\n"
+    "  itemMapView\n"
+    "order by\n"
+    "  flowName\n"
+    "  , categoryName\n"
+    "  , itemName\n");
+
+  while (query.next()) {
+    itemIds << query.value(0).toString();
+    itemNames
+      << query.value(1).toString() + ": " + query.value(2).toString();
+  }
+
+  rulesTableWidget = new QTableWidget(payees.count(), 2, this);
+  rulesTableWidget->setHorizontalHeaderLabels(
+    QStringList() << tr("Payee contains") << tr("Item"));
+  rulesTableWidget->verticalHeader()->hide();
+  rulesTableWidget->horizontalHeader()->setStretchLastSection(true);
+
+  // the pattern starts as the whole payee and can be cut down to the part
+  // that stays the same from one statement to the next
+  for (int row = 0; row < payees.count(); ++row) {
+    rulesTableWidget->setItem(
+      row, PayeeRules_Pattern, new QTableWidgetItem(payees.at(row)));
+
+    QComboBox *itemComboBox = new QComboBox;
+
+    for (int item = 0; item < itemNames.count(); ++item) {
+      itemComboBox->addItem(itemNames.at(item), itemIds.at(item));
+    }
+
+    rulesTableWidget->setCellWidget(row, PayeeRules_Item, itemComboBox);
+  }
+
+  rulesTableWidget->resizeColumnToContents(PayeeRules_Pattern);
+
+  QLabel *label =
+    new QLabel(
+      tr("These payees do not match a rule yet. Choose the item each one "
+        "goes to; the rules are kept for the next import."));
+  label->setWordWrap(true);
+
+  buttonBox =
+    new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+
+  connect(buttonBox, SIGNAL(accepted()), this, SLOT(accept()));
+  connect(buttonBox, SIGNAL(rejected()), this, SLOT(reject()));
+
+  QVBoxLayout *mainLayout = new QVBoxLayout;
+  mainLayout->addWidget(label);
+  mainLayout->addWidget(rulesTableWidget);
+  mainLayout->addWidget(buttonBox);
+  setLayout(mainLayout);
+
+  setWindowTitle(tr("Payee Rules"));
+  resize(600, 400);
+}
+
+QMap<QString, QString> PayeeRulesForm::itemIdsByPattern() const {
+  QMap<QString, QString> rules;
+
+  for (int row = 0; row < rulesTableWidget->rowCount(); ++row) {
+    QString pattern =
+      rulesTableWidget->item(row, PayeeRules_Pattern)->text().simplified();
+
+    QComboBox *itemComboBox =
+      qobject_cast<QComboBox *>(
+        rulesTableWidget->cellWidget(row, PayeeRules_Item));
+
+    QString itemId =
+      itemComboBox->itemData(itemComboBox->currentIndex()).toString();
+
+    if (!pattern.isEmpty() && !itemId.isEmpty()) {
+      rules.insert(pattern, itemId);
+    }
+  }
+
+  return rules;
+}
@@ -0,0 +1,43 @@
+//  Copyright 2014 Jason Eric Timms
+// 
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+// 
+//      http://www.apache.org/licenses/LICENSE-2.0
+// 
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  PayeeRulesForm class definition
+//    The class that asks which item each unmatched payee of an imported
+//    statement goes to, and keeps the answers as payee rules.
+
+#ifndef _PAYEERULESFORM_HPP_
+  #define _PAYEERULESFORM_HPP_
+
+  #include <QDialog>
+  #include <QMap>
+  #include <QStringList>
+
+  class QDialogButtonBox;
+  class QTableWidget;
+
+  namespace Cashflow {
+    class PayeeRulesForm : public QDialog {
+      Q_OBJECT
+  
+    public:
+      PayeeRulesForm(QStringList payees, QWidget *parent = (QWidget *)0);
+
+      QMap<QString, QString> itemIdsByPattern() const;
+    
+    private:
+      QTableWidget *rulesTableWidget;
+      QDialogButtonBox *buttonBox;
+    };
+  }
+#endif //_PAYEERULESFORM_HPP_
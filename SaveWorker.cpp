@@ -0,0 +1,311 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  SaveWorker class source
+//    The thread that copies a snapshot of the working database into a save
+//    file while the main window keeps taking edits.
+
+#include <QtCore>
+#include <QtSql>
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+  #include <sqlite3.h>
+#endif
+
+#ifdef Q_OS_WIN
+  #include <io.h>
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <stdio.h>
+  #include <unistd.h>
+#endif
+
+#include "CompressedFile.hpp"
+#include "SaveWorker.hpp"
+
+using Cashflow::CompressedFile;
+using Cashflow::SaveWorker;
+
+// the snapshot is written beside the save file under this suffix first
+const QString partialFileSuffix = ".partial";
+
+// a compressed save packs a plain snapshot kept under this suffix
+const QString snapshotFileSuffix = ".sqlite";
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+// wait before retrying a backup step when the working file is locked
+const int backupBusyWaitMSecs = 10;
+#else
+// connection the thread uses for the copied file; connections belong to the
+// thread that made them, so this one never touches the main window's
+const QString saveConnectionName = "cashflowSave";
+#endif
+
+// flushes a written file to the disk before it replaces the saved file
+static bool syncFile(QString fileName) {
+  QFile file(fileName);
+
+  bool isRunningOkay = file.open(QIODevice::ReadWrite);
+
+  if (isRunningOkay) {
+#ifdef Q_OS_WIN
+    isRunningOkay = (_commit(file.handle()) == 0);
+#else
+    isRunningOkay = (fsync(file.handle()) == 0);
+#endif
+
+    file.close();
+  }
+
+  return isRunningOkay;
+}
+
+// renames over an existing file in one step, so a crash leaves either the
+// old saved file or the new one and never a partial one
+static bool replaceFile(QString fromFileName, QString toFileName) {
+  bool isRunningOkay = true;
+
+#ifdef Q_OS_WIN
+  isRunningOkay =
+    MoveFileExW(
+      (LPCWSTR)QDir::toNativeSeparators(fromFileName).utf16()
+      , (LPCWSTR)QDir::toNativeSeparators(toFileName).utf16()
+      , MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  isRunningOkay =
+    rename(
+      QFile::encodeName(fromFileName).constData()
+      , QFile::encodeName(toFileName).constData()) == 0;
+
+  // the rename lives in the directory, so flush that as well
+  if (isRunningOkay) {
+    int directory =
+      open(
+        QFile::encodeName(QFileInfo(toFileName).absolutePath()).constData()
+        , O_RDONLY);
+
+    if (directory >= 0) {
+      fsync(directory);
+      close(directory);
+    }
+  }
+#endif
+
+  return isRunningOkay;
+}
+
+SaveWorker::SaveWorker(QObject *parent)
+    : QThread(parent)
+    , savePurpose(SaveFile)
+    , savedLogUndoRedoIndex(0)
+    , saved(false) {
+  // intentionally empty function
+}
+
+void SaveWorker::setJob(
+    QString workingFileName
+    , QString saveFileName
+    , Purpose purpose
+    , qint64 logUndoRedoIndex) {
+  this->workingFileName = workingFileName;
+  this->saveFileName = saveFileName;
+  savePurpose = purpose;
+  savedLogUndoRedoIndex = logUndoRedoIndex;
+  saved = false;
+  saveErrorText = "";
+}
+
+QString SaveWorker::fileName() const {
+  return saveFileName;
+}
+
+SaveWorker::Purpose SaveWorker::purpose() const {
+  return savePurpose;
+}
+
+qint64 SaveWorker::logUndoRedoIndex() const {
+  return savedLogUndoRedoIndex;
+}
+
+bool SaveWorker::isSaved() const {
+  return saved;
+}
+
+QString SaveWorker::errorText() const {
+  return saveErrorText;
+}
+
+void SaveWorker::run() {
+  bool isRunningOkay = true;
+
+  // write the database beside the save file first, so a failure part way
+  // through never touches the file that is already saved
+  QString partialFileName = saveFileName + partialFileSuffix;
+
+  bool isCompressed = CompressedFile::isCompressedFileName(saveFileName);
+
+  QString snapshotFileName =
+    (isCompressed ? partialFileName + snapshotFileSuffix : partialFileName);
+
+  if (QFile::exists(partialFileName)) {
+    QFile::remove(partialFileName);
+  }
+
+  if (QFile::exists(snapshotFileName)) {
+    QFile::remove(snapshotFileName);
+  }
+
+  isRunningOkay = copySnapshot(snapshotFileName);
+
+  if (isRunningOkay
+      && isCompressed
+      && !CompressedFile::compress(snapshotFileName, partialFileName)) {
+    saveErrorText = tr("The saved file could not be compressed.");
+
+    isRunningOkay = false;
+  }
+
+  if (isCompressed
+      && QFile::exists(snapshotFileName)) {
+    QFile::remove(snapshotFileName);
+  }
+
+  // a working copy lost to a crash is made again from the saved file, so
+  // only the saved files are flushed
+  if (isRunningOkay
+      && savePurpose != WorkingCopy
+      && !syncFile(partialFileName)) {
+    saveErrorText = tr("The saved file could not be written to the disk.");
+
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay && !replaceFile(partialFileName, saveFileName)) {
+    saveErrorText = tr("The saved file could not be replaced.");
+
+    isRunningOkay = false;
+  }
+
+  if (!isRunningOkay
+      && QFile::exists(partialFileName)) {
+    QFile::remove(partialFileName);
+  }
+
+  saved = isRunningOkay;
+}
+
+bool SaveWorker::copySnapshot(QString partialFileName) {
+  bool isRunningOkay = true;
+
+#ifdef CASHFLOW_SQLITE_BACKUP
+  // a connection of its own reads the working file under a WAL snapshot, so
+  // edits committed while the copy runs neither block nor restart it
+  sqlite3 *source = 0;
+  sqlite3 *destination = 0;
+
+  if (sqlite3_open_v2(
+        workingFileName.toUtf8().constData()
+        , &source
+        , SQLITE_OPEN_READONLY
+        , 0) != SQLITE_OK
+      || sqlite3_open_v2(
+        partialFileName.toUtf8().constData()
+        , &destination
+        , SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE
+        , 0) != SQLITE_OK) {
+    saveErrorText = tr("The save file could not be created.");
+
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    sqlite3_backup *backup =
+      sqlite3_backup_init(destination, "main", source, "main");
+
+    int result = (backup == 0 ? SQLITE_ERROR : SQLITE_OK);
+
+    // one step copies every page inside a single read transaction
+    while (
+      result == SQLITE_OK
+      || result == SQLITE_BUSY
+      || result == SQLITE_LOCKED)
+    {
+      result = sqlite3_backup_step(backup, -1);
+
+      if (result == SQLITE_BUSY || result == SQLITE_LOCKED) {
+        sqlite3_sleep(backupBusyWaitMSecs);
+      }
+    }
+
+    if (result != SQLITE_DONE) {
+      saveErrorText =
+        tr("The working file could not be copied.")
+        + "\n" + sqlite3_errmsg(destination);
+
+      isRunningOkay = false;
+    }
+
+    if (backup != 0) {
+      sqlite3_backup_finish(backup);
+    }
+  }
+
+  // the copied header keeps the working file's WAL mode, which a saved file
+  // should not carry around with it
+  if (isRunningOkay) {
+    sqlite3_exec(destination, "pragma journal_mode = delete;\n", 0, 0, 0);
+  }
+
+  // a failed open still allocates a connection that has to be closed
+  if (destination != 0) {
+    sqlite3_close(destination);
+  }
+
+  if (source != 0) {
+    sqlite3_close(source);
+  }
+#else
+  // without the backup api the file itself is copied; Data checkpoints the
+  // WAL and holds further checkpoints off, so the file does not change
+  // underneath the copy while new edits go to the WAL
+  if (!QFile::copy(workingFileName, partialFileName)) {
+    saveErrorText = tr("The working file could not be copied.");
+
+    isRunningOkay = false;
+  }
+
+  // the copied header keeps the working file's WAL mode, which a saved file
+  // should not carry around with it
+  if (isRunningOkay) {
+    {
+      QSqlDatabase db =
+        QSqlDatabase::addDatabase("QSQLITE", saveConnectionName);
+
+      db.setDatabaseName(partialFileName);
+
+      if (db.open()) {
+        QSqlQuery query(db);
+        query.exec("pragma journal_mode = delete;\n");
+
+        db.close();
+      }
+    }
+
+    QSqlDatabase::removeDatabase(saveConnectionName);
+  }
+#endif
+
+  return isRunningOkay;
+}
@@ -0,0 +1,64 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  SaveWorker class definition
+//    The thread that copies a snapshot of the working database into a save
+//    file while the main window keeps taking edits, and an opened file into
+//    the working database while the window reads it in place.
+
+#ifndef _CASHFLOW_SAVEWORKER_HPP_
+  #define _CASHFLOW_SAVEWORKER_HPP_
+
+  #include <QString>
+  #include <QThread>
+
+  namespace Cashflow {
+    class SaveWorker : public QThread {
+    public:
+      enum Purpose {
+        SaveFile
+        , BackupFile
+        , AutosaveFile
+        , WorkingCopy
+      };
+
+      SaveWorker(QObject *parent = (QObject *)0);
+
+      void setJob(
+        QString workingFileName
+        , QString saveFileName
+        , Purpose purpose
+        , qint64 logUndoRedoIndex);
+
+      QString fileName() const;
+      Purpose purpose() const;
+      qint64 logUndoRedoIndex() const;
+      bool isSaved() const;
+      QString errorText() const;
+
+    protected:
+      void run();
+
+    private:
+      bool copySnapshot(QString partialFileName);
+
+      QString workingFileName;
+      QString saveFileName;
+      Purpose savePurpose;
+      qint64 savedLogUndoRedoIndex;
+      bool saved;
+      QString saveErrorText;
+    };
+  }
+#endif // _CASHFLOW_SAVEWORKER_HPP_
@@ -150,6 +150,12 @@ QString SqlTableModel::selectStatement() const {
 bool SqlTableModel::submit() {
   bool isRunningOkay = QSqlTableModel::submit();
 
+  // told ahead of dataSubmitted, so anything updated in the before signals
+  // is put right before the views are
+  if (!isRunningOkay) {
+    emit dataSubmitFailed();
+  }
+
   emit dataSubmitted();
 
   return isRunningOkay;
@@ -160,6 +166,10 @@ bool SqlTableModel::removeRow(int row, const QModelIndex &parent) {
 
   isRunningOkay = QSqlTableModel::removeRow(row, parent);
 
+  if (!isRunningOkay) {
+    emit dataSubmitFailed();
+  }
+
   emit dataSubmitted();
 
   return isRunningOkay;
@@ -41,6 +41,7 @@
       bool submit();
     
     signals:
+      void dataSubmitFailed();
       void dataSubmitted();
 
     private:
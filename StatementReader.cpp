@@ -0,0 +1,478 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  StatementReader class source
+//    The class that streams a bank statement in CSV or OFX form a line at a
+//    time and totals its transactions by month and payee.
+//
+//  only the running totals are kept, so the memory used grows with the
+//  number of distinct payees in each month and not with the file
+
+#include <QtCore>
+
+#include "StatementReader.hpp"
+
+using Cashflow::StatementReader;
+
+// months are named the way generated periods are, like "January 2015"
+static const QString periodNameFormat = "MMMM yyyy";
+
+// date forms the banks write into their CSV exports
+static const char *csvDateFormats[] = {
+  "yyyy-MM-dd"
+  , "MM/dd/yyyy"
+  , "M/d/yyyy"
+  , "MM/dd/yy"
+  , "M/d/yy"
+  , "dd.MM.yyyy"
+  , "yyyyMMdd"
+  , 0
+};
+
+// enough of the start of a file to find an OFX header in
+static const int sniffLength = 1024;
+
+static QDate parseCsvDate(QString text) {
+  QDate date;
+
+  text = text.trimmed();
+
+  for (int format = 0; !date.isValid() && csvDateFormats[format]; ++format) {
+    date = QDate::fromString(text, csvDateFormats[format]);
+  }
+
+  // two digit years read as 19xx, which no statement is from
+  if (date.isValid() && date.year() < 1950) {
+    date = date.addYears(100);
+  }
+
+  return date;
+}
+
+// reads an amount like "-1,234.5", "1.234,50", "$12.00" or "(12.00)" into
+// cents without going through a double
+static qint64 parseCents(QString text, bool &isValid) {
+  bool isNegative = false;
+
+  text = text.trimmed();
+
+  if (text.startsWith('(') && text.endsWith(')')) {
+    isNegative = true;
+    text = text.mid(1, text.length() - 2);
+  }
+
+  // the comma is the decimal mark when it comes after the last point, like
+  // "1.234,50", or is the only mark with one or two digits after it, like
+  // "12,50"; otherwise it separates thousands, like "1,234"
+  QChar decimalMark = '.';
+
+  int lastComma = text.lastIndexOf(',');
+  int lastPoint = text.lastIndexOf('.');
+
+  if (lastComma > lastPoint) {
+    int digitsAfterComma = 0;
+
+    for (int position = lastComma + 1; position < text.length(); ++position) {
+      if (text.at(position).isDigit()) {
+        ++digitsAfterComma;
+      }
+    }
+
+    if (lastPoint >= 0 || digitsAfterComma <= 2) {
+      decimalMark = ',';
+    }
+  }
+
+  QString digits;
+  int fractionDigits = -1;
+
+  isValid = true;
+
+  for (int position = 0; isValid && position < text.length(); ++position) {
+    QChar character = text.at(position);
+
+    if (character.isDigit()) {
+      digits += character;
+
+      if (fractionDigits >= 0) {
+        ++fractionDigits;
+      }
+
+      // a third fraction digit means the amount was not read the way it was
+      // written, so the line is skipped rather than imported wrong
+      isValid = (fractionDigits <= 2);
+    } else if (character == decimalMark) {
+      isValid = (fractionDigits < 0);
+      fractionDigits = 0;
+    } else if (character == '-') {
+      isNegative = !isNegative;
+    }
+    // currency signs and codes, thousands separators and spaces are skipped
+  }
+
+  isValid = isValid && !digits.isEmpty();
+
+  qint64 cents = 0;
+
+  if (isValid) {
+    for (int padding = qMax(fractionDigits, 0); padding < 2; ++padding) {
+      digits += '0';
+    }
+
+    cents = digits.toLongLong(&isValid);
+  }
+
+  return (isNegative ? -cents : cents);
+}
+
+// splits one CSV record, with doubled quotes inside quoted fields
+static QStringList splitCsvLine(const QString &line, QChar delimiter) {
+  QStringList fields;
+  QString field;
+
+  bool isQuoted = false;
+
+  for (int position = 0; position < line.length(); ++position) {
+    QChar character = line.at(position);
+
+    if (isQuoted) {
+      if (character != '"') {
+        field += character;
+      } else if (position + 1 < line.length()
+          && line.at(position + 1) == '"') {
+        field += character;
+        ++position;
+      } else {
+        isQuoted = false;
+      }
+    } else if (character == '"') {
+      isQuoted = true;
+    } else if (character == delimiter) {
+      fields << field;
+      field.clear();
+    } else {
+      field += character;
+    }
+  }
+
+  fields << field;
+
+  return fields;
+}
+
+StatementReader::StatementReader()
+    : transactions(0)
+    , skippedLines(0) {
+  // intentionally empty function
+}
+
+bool StatementReader::read(QString fileName) {
+  bool isRunningOkay = true;
+
+  amounts.clear();
+  transactions = 0;
+  skippedLines = 0;
+  readErrorText = "";
+
+  QString suffix = QFileInfo(fileName).suffix().toLower();
+
+  bool isOfx = (suffix == "ofx" || suffix == "qfx");
+
+  if (!isOfx) {
+    QFile file(fileName);
+
+    if (file.open(QIODevice::ReadOnly)) {
+      QByteArray start = file.read(sniffLength);
+
+      isOfx = start.contains("OFXHEADER") || start.contains("<OFX>");
+    }
+  }
+
+  isRunningOkay = (isOfx ? readOfx(fileName) : readCsv(fileName));
+
+  if (isRunningOkay
+      && transactions == 0) {
+    readErrorText = QObject::tr("No transactions were found in the file.");
+
+    isRunningOkay = false;
+  }
+
+  return isRunningOkay;
+}
+
+QList<StatementReader::Total> StatementReader::totals() const {
+  QList<Total> list;
+
+  QHash<QPair<QString, QString>, qint64>::const_iterator iterator;
+
+  for (iterator = amounts.constBegin();
+      iterator != amounts.constEnd();
+      ++iterator) {
+    // the register keeps in and out flows as positive amounts, so a payee's
+    // month goes in by size once its refunds have been netted off
+    if (iterator.value() != 0) {
+      Total total;
+      total.periodName = iterator.key().first;
+      total.payee = iterator.key().second;
+      total.amount = qAbs(iterator.value());
+
+      list << total;
+    }
+  }
+
+  return list;
+}
+
+QStringList StatementReader::payees() const {
+  QSet<QString> names;
+
+  QHash<QPair<QString, QString>, qint64>::const_iterator iterator;
+
+  for (iterator = amounts.constBegin();
+      iterator != amounts.constEnd();
+      ++iterator) {
+    names << iterator.key().second;
+  }
+
+  QStringList list = names.toList();
+  list.sort();
+
+  return list;
+}
+
+int StatementReader::transactionCount() const {
+  return transactions;
+}
+
+int StatementReader::skippedLineCount() const {
+  return skippedLines;
+}
+
+QString StatementReader::errorText() const {
+  return readErrorText;
+}
+
+bool StatementReader::readCsv(QString fileName) {
+  QFile file(fileName);
+
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    readErrorText = file.errorString();
+
+    return false;
+  }
+
+  QTextStream in(&file);
+
+  QString line = in.readLine();
+
+  // the delimiter is whichever one the first line uses most
+  QChar delimiter = ',';
+
+  if (line.count(';') > line.count(delimiter)) {
+    delimiter = ';';
+  }
+
+  if (line.count('\t') > line.count(delimiter)) {
+    delimiter = '\t';
+  }
+
+  int dateColumn = -1;
+  int payeeColumn = -1;
+  int amountColumn = -1;
+  int debitColumn = -1;
+  int creditColumn = -1;
+
+  QStringList headers = splitCsvLine(line, delimiter);
+
+  for (int column = 0; column < headers.count(); ++column) {
+    QString header = headers.at(column).trimmed().toLower();
+
+    if (dateColumn < 0
+        && header.contains("date")) {
+      dateColumn = column;
+    } else if (payeeColumn < 0
+        && (header.contains("payee")
+          || header.contains("description")
+          || header.contains("name")
+          || header.contains("memo"))) {
+      payeeColumn = column;
+    } else if (amountColumn < 0
+        && header.contains("amount")) {
+      amountColumn = column;
+    } else if (debitColumn < 0
+        && (header.contains("debit") || header.contains("withdrawal"))) {
+      debitColumn = column;
+    } else if (creditColumn < 0
+        && (header.contains("credit") || header.contains("deposit"))) {
+      creditColumn = column;
+    }
+  }
+
+  bool hasHeader =
+    dateColumn >= 0
+    && payeeColumn >= 0
+    && (amountColumn >= 0 || debitColumn >= 0 || creditColumn >= 0);
+
+  // without a header the columns are taken as date, payee and amount, and
+  // the first line is a transaction like the rest
+  if (!hasHeader) {
+    dateColumn = 0;
+    payeeColumn = 1;
+    amountColumn = 2;
+    debitColumn = -1;
+    creditColumn = -1;
+  }
+
+  int lastColumn =
+    qMax(
+      qMax(dateColumn, payeeColumn)
+      , qMax(amountColumn, qMax(debitColumn, creditColumn)));
+
+  if (hasHeader) {
+    line = in.readLine();
+  }
+
+  while (!line.isNull()) {
+    if (!line.trimmed().isEmpty()) {
+      QStringList fields = splitCsvLine(line, delimiter);
+
+      bool isValid = (fields.count() > lastColumn);
+
+      QDate date;
+      qint64 amount = 0;
+
+      if (isValid) {
+        date = parseCsvDate(fields.at(dateColumn));
+
+        isValid = date.isValid();
+      }
+
+      if (isValid
+          && amountColumn >= 0) {
+        amount = parseCents(fields.at(amountColumn), isValid);
+      }
+
+      // separate columns hold money out and money in, with one left blank
+      if (isValid
+          && debitColumn >= 0
+          && !fields.at(debitColumn).trimmed().isEmpty()) {
+        amount -= qAbs(parseCents(fields.at(debitColumn), isValid));
+      }
+
+      if (isValid
+          && creditColumn >= 0
+          && !fields.at(creditColumn).trimmed().isEmpty()) {
+        amount += qAbs(parseCents(fields.at(creditColumn), isValid));
+      }
+
+      if (isValid) {
+        addTransaction(date, fields.at(payeeColumn), amount);
+      } else {
+        ++skippedLines;
+      }
+    }
+
+    line = in.readLine();
+  }
+
+  return true;
+}
+
+bool StatementReader::readOfx(QString fileName) {
+  QFile file(fileName);
+
+  if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    readErrorText = file.errorString();
+
+    return false;
+  }
+
+  QTextStream in(&file);
+
+  // matches the SGML form, where a value runs to the next tag, and the XML
+  // form, where it is closed; either may put several tags on one line
+  QRegExp tagPattern("<(/?[A-Za-z0-9.]+)>([^<]*)");
+
+  bool isInTransaction = false;
+
+  QString date;
+  QString name;
+  QString memo;
+  QString amount;
+
+  while (!in.atEnd()) {
+    QString line = in.readLine();
+
+    int position = 0;
+
+    while ((position = tagPattern.indexIn(line, position)) >= 0) {
+      QString tag = tagPattern.cap(1).toUpper();
+      QString value = tagPattern.cap(2).trimmed();
+
+      position += tagPattern.matchedLength();
+
+      if (tag == "STMTTRN") {
+        isInTransaction = true;
+
+        date.clear();
+        name.clear();
+        memo.clear();
+        amount.clear();
+      } else if (tag == "/STMTTRN" && isInTransaction) {
+        isInTransaction = false;
+
+        // dates look like 20150105120000[-5:EST], of which the day will do
+        QDate postedDate = QDate::fromString(date.left(8), "yyyyMMdd");
+
+        bool isValid = postedDate.isValid();
+
+        qint64 cents = 0;
+
+        if (isValid) {
+          cents = parseCents(amount, isValid);
+        }
+
+        QString payee = (name.isEmpty() ? memo : name);
+        payee.replace("&amp;", "&");
+
+        if (isValid) {
+          addTransaction(postedDate, payee, cents);
+        } else {
+          ++skippedLines;
+        }
+      } else if (isInTransaction) {
+        if (tag == "DTPOSTED") {
+          date = value;
+        } else if (tag == "TRNAMT") {
+          amount = value;
+        } else if (tag == "NAME") {
+          name = value;
+        } else if (tag == "MEMO") {
+          memo = value;
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+void StatementReader::addTransaction(QDate date, QString payee, qint64 amount) {
+  ++transactions;
+
+  amounts[
+    qMakePair(
+      QLocale::c().toString(date, periodNameFormat)
+      , payee.simplified())] += amount;
+}
@@ -0,0 +1,61 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  StatementReader class definition
+//    The class that streams a bank statement in CSV or OFX form a line at a
+//    time and totals its transactions by month and payee.
+
+#ifndef _CASHFLOW_STATEMENTREADER_HPP_
+  #define _CASHFLOW_STATEMENTREADER_HPP_
+
+  #include <QDate>
+  #include <QHash>
+  #include <QList>
+  #include <QPair>
+  #include <QString>
+  #include <QStringList>
+
+  namespace Cashflow {
+    class StatementReader {
+    public:
+      // the transactions of one payee in one month, named like the periods
+      struct Total {
+        QString periodName;
+        QString payee;
+        qint64 amount;
+      };
+
+      StatementReader();
+
+      bool read(QString fileName);
+
+      QList<Total> totals() const;
+      QStringList payees() const;
+
+      int transactionCount() const;
+      int skippedLineCount() const;
+      QString errorText() const;
+
+    private:
+      bool readCsv(QString fileName);
+      bool readOfx(QString fileName);
+      void addTransaction(QDate date, QString payee, qint64 amount);
+
+      QHash<QPair<QString, QString>, qint64> amounts;
+      int transactions;
+      int skippedLines;
+      QString readErrorText;
+    };
+  }
+#endif // _CASHFLOW_STATEMENTREADER_HPP_
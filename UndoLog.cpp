@@ -0,0 +1,899 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  UndoLog class source
+//    This class reads the typed records of the undo log and replays them
+//    through prepared statements that are kept for the life of the connection,
+//    keeps the ids of the log's entries in order with the latest records in
+//    memory, marks off undo groups, and merges and trims entries to keep the
+//    log small.
+//
+//  record layout
+//    operation            insert, update or delete of one row, a command,
+//                         or the begin or end marker of a group
+//    tableCode, rowId     the table and id of the row
+//    oldValue1..5         the row before, in rowColumns order for a delete
+//                         and editColumns order for an update
+//    newValue1..5         the row after, in the same orders
+//    undoCommand and      SQL text, only for commands
+//    redoCommand
+//    loggedAt             milliseconds since the epoch
+//
+//  the entries between a begin and an end marker undo and redo as one step
+
+#include <QtGui>
+#include <QtSql>
+
+#include "cashflow.hpp"
+#include "UndoLog.hpp"
+
+using Cashflow::UndoLog;
+
+// value columns on each side of a record
+static const int valueColumnCount = 5;
+
+static QString tableName(int table) {
+  QString name = "";
+
+  switch (table) {
+    case UndoLog::PeriodTable:
+      name = "period";
+      break;
+    case UndoLog::CategoryTable:
+      name = "category";
+      break;
+    case UndoLog::ItemTable:
+      name = "item";
+      break;
+    case UndoLog::RegisterTable:
+      name = "register";
+      break;
+  }
+
+  return name;
+}
+
+// the columns after the id that put a whole row back
+static QStringList rowColumns(int table) {
+  QStringList columns;
+
+  switch (table) {
+    case UndoLog::PeriodTable:
+      columns << "name";
+      break;
+    case UndoLog::CategoryTable:
+      columns << "name" << "flowId";
+      break;
+    case UndoLog::ItemTable:
+      columns << "name" << "categoryId";
+      break;
+    case UndoLog::RegisterTable:
+      columns << "periodId" << "itemId" << "budget" << "actual" << "note";
+      break;
+  }
+
+  return columns;
+}
+
+// the columns an edit through the views changes, which for the register
+// leaves the period and item alone
+static QStringList editColumns(int table) {
+  QStringList columns;
+
+  if (table == UndoLog::RegisterTable) {
+    columns << "budget" << "actual" << "note";
+  } else {
+    columns = rowColumns(table);
+  }
+
+  return columns;
+}
+
+// the record's columns, in the order readRecordValues takes them
+static QString recordColumns() {
+  QStringList columns;
+  columns << "operation" << "tableCode" << "rowId";
+
+  for (int value = 1; value <= valueColumnCount; ++value) {
+    columns << QString("oldValue%1").arg(value);
+  }
+
+  for (int value = 1; value <= valueColumnCount; ++value) {
+    columns << QString("newValue%1").arg(value);
+  }
+
+  columns << "undoCommand" << "redoCommand";
+
+  return columns.join("\n  , ");
+}
+
+static void readRecordValues(
+    const QSqlQuery &query, int firstColumn, UndoLog::Record &record) {
+  record.operation = query.value(firstColumn).toInt();
+  record.table = query.value(firstColumn + 1).toInt();
+  record.rowId = query.value(firstColumn + 2).toLongLong();
+
+  record.oldValues.clear();
+  record.newValues.clear();
+
+  for (int value = 0; value < valueColumnCount; ++value) {
+    record.oldValues << query.value(firstColumn + 3 + value);
+    record.newValues
+      << query.value(firstColumn + 3 + valueColumnCount + value);
+  }
+
+  record.undoCommand =
+    query.value(firstColumn + 3 + 2 * valueColumnCount).toString();
+  record.redoCommand =
+    query.value(firstColumn + 4 + 2 * valueColumnCount).toString();
+}
+
+static void warnOfError(const QSqlQuery &query, QString message) {
+  QString title =
+    QObject::tr("Error Type=")
+    + query.lastError().type()
+    + " "
+    + QObject::tr(message.toUtf8());
+  QString text = ATLINE + ":" + query.lastError().text();
+
+  // a command-line export loads the log without a window to warn in
+  if (QApplication::type() == QApplication::Tty) {
+    qWarning("%s %s", qPrintable(title), qPrintable(text));
+  } else {
+    QMessageBox::warning((QWidget *)0, title, text);
+  }
+}
+
+UndoLog::UndoLog()
+    : cachedRecords(UNDO_CACHED_RECORDS)
+    , groupDepth(0)
+    , groupBeginId(0) {
+  // intentionally empty function
+}
+
+QString UndoLog::loggedStatement(
+    Operation operation
+    , Table table
+    , QString rowId
+    , QStringList oldValues
+    , QStringList newValues) {
+  QStringList columns;
+  QStringList values;
+
+  columns << "operation" << "tableCode" << "rowId";
+  values
+    << QString::number(operation)
+    << QString::number(table)
+    << rowId;
+
+  for (int value = 0; value < oldValues.count(); ++value) {
+    columns << QString("oldValue%1").arg(value + 1);
+    values << oldValues.at(value);
+  }
+
+  for (int value = 0; value < newValues.count(); ++value) {
+    columns << QString("newValue%1").arg(value + 1);
+    values << newValues.at(value);
+  }
+
+  return
+    "    insert into logUndoRedo(\n"
+    "      " + columns.join("\n      , ") + ")\n"
+    "    values(\n"
+    "      " + values.join("\n      , ") + ");\n";
+}
+
+bool UndoLog::load() {
+  entryIds.clear();
+  entryOperations.clear();
+  entryTimes.clear();
+  cachedRecords.clear();
+  groupDepth = 0;
+
+  return readNewEntries();
+}
+
+void UndoLog::clear() {
+  // the statements belong to the connection, so they go before it closes
+  statements.clear();
+  entryIds.clear();
+  entryOperations.clear();
+  entryTimes.clear();
+  cachedRecords.clear();
+  groupDepth = 0;
+}
+
+void UndoLog::setCachedRecordCount(int cachedRecordCount) {
+  cachedRecords.setMaxCost(cachedRecordCount);
+}
+
+qint64 UndoLog::count() {
+  // the triggers add entries behind the program's back, so pick them up
+  readNewEntries();
+
+  return entryIds.count();
+}
+
+qint64 UndoLog::entryId(qint64 index) const {
+  // the cursor counts from one
+  return entryIds.value(index - 1, 0);
+}
+
+bool UndoLog::remove(qint64 firstIndex, qint64 lastIndex) {
+  bool isRunningOkay = true;
+
+  if (firstIndex < 1
+      || firstIndex > lastIndex
+      || lastIndex > entryIds.count()) {
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    QSqlQuery &query = statement(
+      "deleteEntries"
+      , "delete\n"
+        "from\n"
+        "  logUndoRedo\n"
+        "where\n"
+        "  id between ? and ?\n");
+    query.bindValue(0, entryId(firstIndex));
+    query.bindValue(1, entryId(lastIndex));
+
+    if (!query.exec()) {
+      warnOfError(query, "Invalid delete from logUndoRedo table.");
+
+      isRunningOkay = false;
+    }
+  }
+
+  if (isRunningOkay) {
+    for (qint64 index = firstIndex; index <= lastIndex; ++index) {
+      cachedRecords.remove(entryId(index));
+    }
+
+    entryIds.remove(firstIndex - 1, lastIndex - firstIndex + 1);
+    entryOperations.remove(firstIndex - 1, lastIndex - firstIndex + 1);
+    entryTimes.remove(firstIndex - 1, lastIndex - firstIndex + 1);
+  }
+
+  return isRunningOkay;
+}
+
+void UndoLog::rollBackTo(qint64 count) {
+  // the entries a rolled back transaction logged are gone from the table,
+  // so they go from memory as well
+  for (qint64 index = count + 1; index <= entryIds.count(); ++index) {
+    cachedRecords.remove(entryId(index));
+  }
+
+  if (count < entryIds.count()) {
+    entryIds.resize(count);
+    entryOperations.resize(count);
+    entryTimes.resize(count);
+  }
+}
+
+bool UndoLog::logRecords(
+    Operation operation
+    , Table table
+    , const QVariantList &rowIds
+    , const QList<QVariantList> &oldColumns
+    , const QList<QVariantList> &newColumns) {
+  bool isRunningOkay = true;
+
+  // the bulk changes write to the tables directly, where no trigger logs
+  // them, so they log a record per row, each value column bound as a list
+  // and written as one batch
+  if (!rowIds.isEmpty()) {
+    QStringList columns;
+    columns << "operation" << "tableCode" << "rowId";
+
+    for (int value = 1; value <= oldColumns.count(); ++value) {
+      columns << QString("oldValue%1").arg(value);
+    }
+
+    for (int value = 1; value <= newColumns.count(); ++value) {
+      columns << QString("newValue%1").arg(value);
+    }
+
+    QVariantList operations;
+    QVariantList tables;
+
+    for (int row = 0; row < rowIds.count(); ++row) {
+      operations << operation;
+      tables << table;
+    }
+
+    QSqlQuery &query = statement(
+      QString("logRecords%1_%2")
+        .arg(oldColumns.count())
+        .arg(newColumns.count())
+      , "insert into logUndoRedo(\n"
+        "  " + columns.join("\n  , ") + ")\n"
+        "values(\n"
+        "  ?" + QString("\n  , ?").repeated(columns.count() - 1) + ")\n");
+    query.bindValue(0, operations);
+    query.bindValue(1, tables);
+    query.bindValue(2, rowIds);
+
+    int column = 3;
+
+    foreach(const QVariantList &values, oldColumns) {
+      query.bindValue(column++, values);
+    }
+
+    foreach(const QVariantList &values, newColumns) {
+      query.bindValue(column++, values);
+    }
+
+    if (!query.execBatch()) {
+      warnOfError(query, "Invalid insert into logUndoRedo table.");
+
+      isRunningOkay = false;
+    }
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::coalesce(qint64 index, qint64 windowMilliseconds) {
+  bool isRunningOkay = true;
+
+  // only the last entry is merged, into the one before it, and only when
+  // both update the same row close enough together
+  if (index < 1
+      || index + 1 != entryIds.count()
+      || entryOperations.at(index - 1) != UpdateOperation
+      || entryOperations.at(index) != UpdateOperation
+      || entryTimes.at(index) - entryTimes.at(index - 1) > windowMilliseconds) {
+    isRunningOkay = false;
+  }
+
+  Record earlier;
+  Record later;
+
+  if (isRunningOkay) {
+    isRunningOkay =
+      readRecord(entryId(index), earlier)
+      && readRecord(entryId(index + 1), later)
+      && earlier.table == later.table
+      && earlier.rowId == later.rowId;
+  }
+
+  QSqlDatabase db = QSqlDatabase::database();
+
+  bool isInTransaction = false;
+
+  // the update and the delete go together or not at all, so without a
+  // transaction of its own the entries are left as they are
+  if (isRunningOkay) {
+    isInTransaction = db.transaction();
+
+    isRunningOkay = isInTransaction;
+  }
+
+  // the earlier entry keeps its old values and takes on the later one's new
+  // values, so undoing it goes back past both
+  if (isRunningOkay) {
+    QStringList assignments;
+
+    for (int value = 1; value <= valueColumnCount; ++value) {
+      assignments << QString("newValue%1 = ?").arg(value);
+    }
+
+    QSqlQuery &query = statement(
+      "coalesce"
+      , "update logUndoRedo\n"
+        "set\n"
+        "  " + assignments.join("\n  , ") + "\n"
+        "  , loggedAt = ?\n"
+        "where\n"
+        "  id = ?\n");
+
+    for (int value = 0; value < valueColumnCount; ++value) {
+      query.bindValue(value, later.newValues.at(value));
+    }
+
+    query.bindValue(valueColumnCount, entryTimes.at(index));
+    query.bindValue(valueColumnCount + 1, entryId(index));
+
+    if (!query.exec()) {
+      warnOfError(query, "Invalid update of logUndoRedo table.");
+
+      isRunningOkay = false;
+    }
+  }
+
+  if (isRunningOkay) {
+    entryTimes[index - 1] = entryTimes.at(index);
+
+    if (cachedRecords.contains(entryId(index))) {
+      cachedRecords.object(entryId(index))->newValues = later.newValues;
+    }
+
+    isRunningOkay = remove(index + 1, index + 1);
+  }
+
+  if (isRunningOkay) {
+    db.commit();
+  } else if (isInTransaction) {
+    db.rollback();
+
+    // the log as it stands on disk is read again from the start
+    load();
+  }
+
+  return isRunningOkay;
+}
+
+qint64 UndoLog::compact(
+    qint64 lastIndex, qint64 loggedBefore, qint64 maxCount) {
+  qint64 removedCount = 0;
+
+  // entries go from the front while they are past the horizon or over the
+  // count, and the log is only cut between groups, so a group that has
+  // started going goes whole
+  qint64 overCount = entryIds.count() - maxCount;
+
+  int depth = 0;
+
+  for (qint64 index = 1;
+      index <= qMin(lastIndex, (qint64)entryIds.count())
+        && (index <= overCount
+          || entryTimes.at(index - 1) < loggedBefore
+          || depth > 0);
+      ++index) {
+    int operation = entryOperations.at(index - 1);
+
+    if (operation == GroupBeginOperation) {
+      ++depth;
+    } else if (operation == GroupEndOperation && depth > 0) {
+      --depth;
+    }
+
+    if (depth == 0) {
+      removedCount = index;
+    }
+  }
+
+  if (removedCount > 0
+      && !remove(1, removedCount)) {
+    removedCount = 0;
+  }
+
+  return removedCount;
+}
+
+bool UndoLog::beginGroup() {
+  bool isRunningOkay = true;
+
+  if (groupDepth == 0) {
+    isRunningOkay = insertMarker(GroupBeginOperation);
+
+    if (isRunningOkay) {
+      groupBeginId = entryIds.last();
+    }
+  }
+
+  if (isRunningOkay) {
+    ++groupDepth;
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::endGroup() {
+  bool isRunningOkay = true;
+
+  if (groupDepth == 0) {
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    --groupDepth;
+  }
+
+  if (isRunningOkay
+      && groupDepth == 0) {
+    qint64 lastIndex = count();
+
+    // a group that logged nothing leaves nothing behind
+    if (lastIndex > 0
+        && entryIds.last() == groupBeginId) {
+      isRunningOkay = remove(lastIndex, lastIndex);
+    } else {
+      isRunningOkay = insertMarker(GroupEndOperation);
+    }
+  }
+
+  return isRunningOkay;
+}
+
+qint64 UndoLog::groupStart(qint64 lastIndex) const {
+  qint64 firstIndex = lastIndex;
+
+  // walk back from an end marker to its begin marker, which costs no more
+  // than replaying the group does
+  if (entryOperations.value(lastIndex - 1) == GroupEndOperation) {
+    qint64 index = lastIndex - 1;
+
+    while (index > 0
+        && entryOperations.at(index - 1) != GroupBeginOperation) {
+      --index;
+    }
+
+    // an end marker without its begin stands alone
+    if (index > 0) {
+      firstIndex = index;
+    }
+  }
+
+  return firstIndex;
+}
+
+qint64 UndoLog::groupEnd(qint64 firstIndex) const {
+  qint64 lastIndex = firstIndex;
+
+  if (entryOperations.value(firstIndex - 1) == GroupBeginOperation) {
+    qint64 index = firstIndex + 1;
+
+    while (index <= entryOperations.count()
+        && entryOperations.at(index - 1) != GroupEndOperation) {
+      ++index;
+    }
+
+    // a begin marker without its end, from a crash part way through a
+    // group, stands alone
+    if (index <= entryOperations.count()) {
+      lastIndex = index;
+    }
+  }
+
+  return lastIndex;
+}
+
+bool UndoLog::undo(qint64 firstIndex, qint64 lastIndex) {
+  return replayInTransaction(firstIndex, lastIndex, true);
+}
+
+bool UndoLog::redo(qint64 firstIndex, qint64 lastIndex) {
+  return replayInTransaction(firstIndex, lastIndex, false);
+}
+
+bool UndoLog::readNewEntries() {
+  bool isRunningOkay = true;
+
+  // new rows take ids past the largest one, so only the entries after the
+  // last known one need reading, and that is a seek on the primary key; a
+  // file without the table yet just has no entries
+  QSqlQuery &query = statement(
+    "selectNewIds"
+    , "select\n"
+      "  id\n"
+      "  , loggedAt\n"
+      "  , " + recordColumns() + "\n"
+      "from\n"
+      "  logUndoRedo\n"
+      "where\n"
+      "  id > ?\n"
+      "order by\n"
+      "  id\n");
+  query.bindValue(0, (entryIds.isEmpty() ? 0 : entryIds.last()));
+
+  isRunningOkay = query.exec();
+
+  // the records are kept while they are read anyway, and the oldest fall
+  // out of the cache as the newest go in
+  while (isRunningOkay && query.next()) {
+    Record *record = new Record;
+    readRecordValues(query, 2, *record);
+
+    entryIds << query.value(0).toLongLong();
+    entryOperations << record->operation;
+    entryTimes << query.value(1).toLongLong();
+
+    cachedRecords.insert(entryIds.last(), record);
+  }
+
+  query.finish();
+
+  // a statement prepared before the table was there is made again next time
+  if (!isRunningOkay) {
+    statements.remove("selectNewIds");
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::insertMarker(Operation operation) {
+  bool isRunningOkay = true;
+
+  QSqlQuery &query = statement(
+    "insertMarker"
+    , "insert into logUndoRedo(\n"
+      "  operation)\n"
+      "values(\n"
+      "  ?)\n");
+  query.bindValue(0, operation);
+
+  if (!query.exec()) {
+    warnOfError(query, "Invalid insert into logUndoRedo table.");
+
+    isRunningOkay = false;
+  }
+
+  if (isRunningOkay) {
+    isRunningOkay = readNewEntries();
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::replayInTransaction(
+    qint64 firstIndex, qint64 lastIndex, bool isUndo) {
+  bool isRunningOkay = true;
+
+  QSqlDatabase db = QSqlDatabase::database();
+
+  if (firstIndex < 1
+      || firstIndex > lastIndex
+      || lastIndex > entryIds.count()) {
+    isRunningOkay = false;
+  }
+
+  bool isInTransaction = false;
+
+  // a group never replays part way outside a transaction, so a failed begin
+  // replays nothing
+  if (isRunningOkay) {
+    isInTransaction = db.transaction();
+
+    isRunningOkay = isInTransaction;
+  }
+
+  // a group undoes from its last entry back and redoes from its first on,
+  // all in the one transaction
+  int step = (isUndo ? -1 : 1);
+
+  for (qint64 index = (isUndo ? lastIndex : firstIndex);
+      isRunningOkay && index >= firstIndex && index <= lastIndex;
+      index += step) {
+    int operation = entryOperations.at(index - 1);
+
+    // the markers change nothing
+    if (operation != GroupBeginOperation
+        && operation != GroupEndOperation) {
+      Record record;
+
+      isRunningOkay =
+        readRecord(entryId(index), record)
+        && replay(record, isUndo);
+    }
+  }
+
+  if (isRunningOkay) {
+    db.commit();
+  } else if (isInTransaction) {
+    db.rollback();
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::readRecord(qint64 id, Record &record) {
+  bool isRunningOkay = true;
+
+  // the latest entries are answered from memory
+  bool isCached = cachedRecords.contains(id);
+
+  if (isCached) {
+    record = *cachedRecords.object(id);
+  }
+
+  // older ones are read back from the table one at a time as the undo
+  // reaches them
+  if (!isCached) {
+    QSqlQuery &query = statement(
+      "select"
+      , "select\n"
+        "  " + recordColumns() + "\n"
+        "from\n"
+        "  logUndoRedo\n"
+        "where\n"
+        "  id = ?\n");
+    query.bindValue(0, id);
+
+    if (query.exec() && query.next()) {
+      readRecordValues(query, 0, record);
+    } else {
+      QMessageBox::warning(
+        (QWidget *)0
+        , QObject::tr("Could not get undo log entry.")
+        , QObject::tr("The undo log entry is missing."));
+
+      isRunningOkay = false;
+    }
+
+    // let go of the read before the replay writes
+    query.finish();
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::replay(const Record &record, bool isUndo) {
+  bool isRunningOkay = true;
+
+  switch (record.operation) {
+    case CommandOperation:
+      isRunningOkay =
+        executeCommand(isUndo ? record.undoCommand : record.redoCommand);
+      break;
+    case InsertOperation:
+      isRunningOkay = (
+        isUndo
+        ? deleteRow(record.table, record.rowId)
+        : insertRow(record.table, record.rowId, record.newValues));
+      break;
+    case UpdateOperation:
+      isRunningOkay =
+        updateRow(
+          record.table
+          , record.rowId
+          , (isUndo ? record.oldValues : record.newValues));
+      break;
+    case DeleteOperation:
+      isRunningOkay = (
+        isUndo
+        ? insertRow(record.table, record.rowId, record.oldValues)
+        : deleteRow(record.table, record.rowId));
+      break;
+    case GroupBeginOperation:
+    case GroupEndOperation:
+      break;
+    default:
+      isRunningOkay = false;
+      break;
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::insertRow(int table, qint64 rowId, const QVariantList &values) {
+  bool isRunningOkay = true;
+
+  QStringList columns = rowColumns(table);
+
+  QSqlQuery &query = statement(
+    QString("insert%1").arg(table)
+    , "insert into " + tableName(table) + "(\n"
+      "  id\n"
+      "  , " + columns.join("\n  , ") + ")\n"
+      "values(\n"
+      "  ?" + QString("\n  , ?").repeated(columns.count()) + ")\n");
+  query.bindValue(0, rowId);
+
+  for (int column = 0; column < columns.count(); ++column) {
+    query.bindValue(column + 1, values.value(column));
+  }
+
+  if (!query.exec()) {
+    warnOfError(query, "Could not put back the undone row.");
+
+    isRunningOkay = false;
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::updateRow(int table, qint64 rowId, const QVariantList &values) {
+  bool isRunningOkay = true;
+
+  QStringList columns = editColumns(table);
+
+  QSqlQuery &query = statement(
+    QString("update%1").arg(table)
+    , "update " + tableName(table) + "\n"
+      "set\n"
+      "  " + columns.join(" = ?\n  , ") + " = ?\n"
+      "where\n"
+      "  id = ?\n");
+
+  for (int column = 0; column < columns.count(); ++column) {
+    query.bindValue(column, values.value(column));
+  }
+
+  query.bindValue(columns.count(), rowId);
+
+  if (!query.exec()) {
+    warnOfError(query, "Could not change back the undone row.");
+
+    isRunningOkay = false;
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::deleteRow(int table, qint64 rowId) {
+  bool isRunningOkay = true;
+
+  QSqlQuery &query = statement(
+    QString("delete%1").arg(table)
+    , "delete\n"
+      "from\n"
+      "  " + tableName(table) + "\n"
+      "where\n"
+      "  id = ?\n");
+  query.bindValue(0, rowId);
+
+  if (!query.exec()) {
+    warnOfError(query, "Could not remove the undone row.");
+
+    isRunningOkay = false;
+  }
+
+  return isRunningOkay;
+}
+
+bool UndoLog::executeCommand(QString command) {
+  bool isRunningOkay = true;
+
+  // a logged command may hold several statements, so split it on the
+  // semicolons that are outside of quoted values
+  QStringList commandStatements;
+  QString commandStatement = "";
+  bool isInQuote = false;
+
+  foreach(QChar character, command) {
+    if (character == '\'') {
+      isInQuote = !isInQuote;
+    }
+
+    if (character == ';' && !isInQuote) {
+      commandStatements << commandStatement;
+      commandStatement = "";
+    } else {
+      commandStatement += character;
+    }
+  }
+
+  commandStatements << commandStatement;
+
+  foreach(QString part, commandStatements) {
+    if (isRunningOkay
+        && !part.trimmed().isEmpty()) {
+      QSqlQuery query;
+
+      if (!query.exec(part)) {
+        warnOfError(query, "Could not run the logged command.");
+
+        isRunningOkay = false;
+      }
+    }
+  }
+
+  return isRunningOkay;
+}
+
+QSqlQuery &UndoLog::statement(QString key, QString sql) {
+  if (!statements.contains(key)) {
+    QSqlQuery query;
+    query.setForwardOnly(true);
+    query.prepare(sql);
+
+    statements.insert(key, query);
+  }
+
+  return statements[key];
+}
@@ -0,0 +1,135 @@
+//  Copyright 2014 Jason Eric Timms
+//
+//    Licensed under the Apache License, Version 2.0 (the "License");
+//    you may not use this file except in compliance with the License.
+//    You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//    Unless required by applicable law or agreed to in writing, software
+//    distributed under the License is distributed on an "AS IS" BASIS,
+//    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//    See the License for the specific language governing permissions and
+//    limitations under the License.
+//
+//  UndoLog class definition
+//    This class reads the typed records of the undo log and replays them
+//    through prepared statements that are kept for the life of the connection,
+//    keeps the ids of the log's entries in order with the latest records in
+//    memory, marks off undo groups, and merges and trims entries to keep the
+//    log small.
+
+#ifndef _CASHFLOW_UNDOLOG_HPP_
+  #define _CASHFLOW_UNDOLOG_HPP_
+
+  #include <QCache>
+  #include <QHash>
+  #include <QSqlQuery>
+  #include <QString>
+  #include <QStringList>
+  #include <QVariantList>
+  #include <QVector>
+
+  namespace Cashflow {
+    class UndoLog {
+    public:
+      // stored in logUndoRedo.operation, so the values must not change
+      enum Operation {
+        CommandOperation = 0
+        , InsertOperation = 1
+        , UpdateOperation = 2
+        , DeleteOperation = 3
+        , GroupBeginOperation = 4
+        , GroupEndOperation = 5
+      };
+
+      // stored in logUndoRedo.tableCode, so the values must not change
+      enum Table {
+        NoTable = 0
+        , PeriodTable = 1
+        , CategoryTable = 2
+        , ItemTable = 3
+        , RegisterTable = 4
+      };
+
+      // one row of the log; a command keeps SQL text, which only history
+      // converted from older files has, the rest keep column values
+      struct Record {
+        int operation;
+        int table;
+        qint64 rowId;
+        QVariantList oldValues;
+        QVariantList newValues;
+        QString undoCommand;
+        QString redoCommand;
+      };
+
+      UndoLog();
+
+      static QString loggedStatement(
+        Operation operation
+        , Table table
+        , QString rowId
+        , QStringList oldValues
+        , QStringList newValues);
+
+      bool load();
+      void clear();
+      void setCachedRecordCount(int cachedRecordCount);
+
+      qint64 count();
+      qint64 entryId(qint64 index) const;
+      bool remove(qint64 firstIndex, qint64 lastIndex);
+      void rollBackTo(qint64 count);
+
+      bool logRecords(
+        Operation operation
+        , Table table
+        , const QVariantList &rowIds
+        , const QList<QVariantList> &oldColumns
+        , const QList<QVariantList> &newColumns);
+
+      bool beginGroup();
+      bool endGroup();
+      qint64 groupStart(qint64 lastIndex) const;
+      qint64 groupEnd(qint64 firstIndex) const;
+
+      bool coalesce(qint64 index, qint64 windowMilliseconds);
+      qint64 compact(qint64 lastIndex, qint64 loggedBefore, qint64 maxCount);
+
+      bool undo(qint64 firstIndex, qint64 lastIndex);
+      bool redo(qint64 firstIndex, qint64 lastIndex);
+
+    private:
+      bool readNewEntries();
+      bool insertMarker(Operation operation);
+      bool replayInTransaction(
+        qint64 firstIndex, qint64 lastIndex, bool isUndo);
+      bool readRecord(qint64 id, Record &record);
+      bool replay(const Record &record, bool isUndo);
+      bool insertRow(int table, qint64 rowId, const QVariantList &values);
+      bool updateRow(int table, qint64 rowId, const QVariantList &values);
+      bool deleteRow(int table, qint64 rowId);
+      bool executeCommand(QString command);
+      QSqlQuery &statement(QString key, QString sql);
+
+      // prepared once per connection, keyed by statement kind and table
+      QHash<QString, QSqlQuery> statements;
+
+      // ids of the entries in log order, so the n-th entry is found without
+      // counting or scanning the table, and the operation of each and the
+      // time it was logged, in milliseconds since the epoch
+      QVector<qint64> entryIds;
+      QVector<int> entryOperations;
+      QVector<qint64> entryTimes;
+
+      // records of the latest entries by id, so an undo soon after the change
+      // reads nothing back; the rest stay in the table until they are needed
+      QCache<qint64, Record> cachedRecords;
+
+      // nested groups fold into the outermost one
+      int groupDepth;
+      qint64 groupBeginId;
+    };
+  }
+#endif // _CASHFLOW_UNDOLOG_HPP_
@@ -34,6 +34,21 @@
   const int INITIAL_WINDOW_X = 200;
   const int INITIAL_WINDOW_Y = 200;
 
+  // minutes between background autosaves, where 0 turns them off
+  const int AUTOSAVE_INTERVAL_MINUTES = 5;
+
+  // sqlite connection profile defaults, tunable in the Performance settings
+  const int SQLITE_PAGE_SIZE = 4096;
+  const int SQLITE_CACHE_SIZE_KIB = 16384;
+  const qint64 SQLITE_MMAP_SIZE = 268435456;
+
+  // undo history defaults, tunable in the UndoHistory settings, where 0 turns
+  // any of them off
+  const int UNDO_COALESCE_MILLISECONDS = 3000;
+  const int UNDO_HORIZON_DAYS = 365;
+  const int UNDO_MAX_ENTRIES = 10000;
+  const int UNDO_CACHED_RECORDS = 256;
+
   const QString imagePath =
     ":/images/";
 
@@ -40,26 +40,56 @@ INCLUDEPATH += .
 
 QT += sql
 
+# open and save files with the sqlite online backup api, which has to come
+# from the same library the Qt driver uses; that is the system sqlite on most
+# Linux builds of Qt, so pass CONFIG+=no_sqlite_backup where Qt bundles its own
+unix:!macx:!no_sqlite_backup {
+  DEFINES += CASHFLOW_SQLITE_BACKUP
+  LIBS += -lsqlite3
+}
+
 #FORMS += .
 HEADERS = \
   Application.hpp \
   cashflow.hpp \
+  CompressedFile.hpp \
+  ConsolidatedReport.hpp \
+  ConsolidatedReportForm.hpp \
   Data.hpp \
   DecimalFieldItemDelegate.hpp \
+  Exporter.hpp \
+  GeneratePeriodsForm.hpp \
   HeaderView.hpp \
   ManageCategoriesForm.hpp \
   ManageItemsForm.hpp \
   MainForm.hpp \
+  MetricsCache.hpp \
+  MetricsModel.hpp \
+  PayeeRulesForm.hpp \
+  SaveWorker.hpp \
   SqlTableModel.hpp \
-  TableView.hpp
+  StatementReader.hpp \
+  TableView.hpp \
+  UndoLog.hpp
 SOURCES = \
   Application.cpp \
+  CompressedFile.cpp \
+  ConsolidatedReport.cpp \
+  ConsolidatedReportForm.cpp \
   Data.cpp \
+  Exporter.cpp \
+  GeneratePeriodsForm.cpp \
   ManageCategoriesForm.cpp \
   ManageItemsForm.cpp \
   MainForm.cpp \
+  MetricsCache.cpp \
+  MetricsModel.cpp \
+  PayeeRulesForm.cpp \
+  SaveWorker.cpp \
   SqlTableModel.cpp \
+  StatementReader.cpp \
   TableView.cpp \
+  UndoLog.cpp \
   main.cpp
 RESOURCES = \
   cashflow.qrc
@@ -22,7 +22,14 @@
 using Cashflow::Application;
 
 int main(int argc, char **argv) {
-  Application app(argc, argv);
+  // an export from the command line writes its file and exits, so it runs
+  // without the GUI and needs no display
+  Application app(
+    argc, argv, !Application::isCommandLineExport(argc, argv));
+
+  if (app.isCommandLineExport()) {
+    return app.exportFromCommandLine();
+  }
 
   return app.exec();
 }